@@ -0,0 +1,523 @@
+// Distance kernel microbenchmark.
+//
+// Times every kernel at every SIMD level the CPU supports (fixed-dimension
+// kernels only at their dims, the Distance entry points and PQ lookups only
+// at the active level), over a matrix of dims and two working sets:
+//   - "cache": a small block of rows reused on every pass (stays in L1/L2)
+//   - "mem":   a large buffer streamed from DRAM, in row order ("seq") and in
+//              a shuffled order ("rand", closer to HNSW's access pattern)
+//
+// One result per line, CSV (default) or JSON, so runs can be diffed between
+// builds:
+//   vecdb_bench_distance [--format csv|json] [--out file] [--dims 128,768]
+//                        [--cache-kb 64] [--mem-mb 128] [--min-ms 20]
+//                        [--active-only]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vecdb/AlignedAllocator.h"
+#include "vecdb/BinaryQuantizer.h"
+#include "vecdb/Distance.h"
+#include "vecdb/DistanceSimd.h"
+#include "vecdb/Half.h"
+#include "vecdb/ProductQuantizer.h"
+#include "vecdb/ScalarQuantizer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+namespace simd = vecdb::simd;
+
+// Rows handed to one kernel case, in the order they are visited.
+struct Workload {
+  std::size_t dim = 0;
+  const float* query = nullptr;
+  std::vector<const float*> rows;
+  std::vector<float> inv_rows;  // 1/||row||, for the cosine entry points
+
+  // Bound for the early-abandon kernels: the 1st percentile of the query's
+  // l2_sq over the rows, about where an HNSW result heap's worst entry sits.
+  float l2_bound = 0.0f;
+
+  // SQ8 codes of the same rows, same order (see ScalarQuantizer).
+  const float* sq8_scale = nullptr;
+  std::vector<const std::uint8_t*> codes;
+
+  // The same rows encoded as F16 / BF16 (see RowFormat).
+  std::vector<const std::uint16_t*> f16_rows;
+  std::vector<const std::uint16_t*> bf16_rows;
+
+  // PQ codes of the same rows (see ProductQuantizer).
+  const vecdb::ProductQuantizer* pq = nullptr;
+  std::vector<const std::uint8_t*> pq_codes;
+
+  // Sign-bit codes of the same rows (see BinaryQuantizer).
+  const std::uint64_t* query_bits = nullptr;
+  std::size_t bit_words = 0;
+  std::vector<const std::uint64_t*> bits;
+
+  // The same rows copied to a padded, line-aligned layout (VectorStore
+  // pad_rows), with the query padded to match.
+  std::size_t stride = 0;
+  const float* padded_query = nullptr;
+  std::vector<const float*> padded_rows;
+};
+
+// One timed kernel. pass() scores query against every row once and returns
+// a value derived from the results so the calls cannot be optimized away.
+// applies() (when set) skips levels / dims the kernel does not exist for.
+struct KernelCase {
+  const char* name;
+  std::size_t (*bytes_per_row)(std::size_t dim);
+  float (*pass)(const simd::Kernels& k, const Workload& w);
+  bool (*applies)(const simd::Kernels& k, const Workload& w) = nullptr;
+};
+
+std::size_t float_row_bytes(std::size_t dim) { return dim * sizeof(float); }
+std::size_t half_row_bytes(std::size_t dim) { return dim * sizeof(std::uint16_t); }
+std::size_t sq8_row_bytes(std::size_t dim) { return dim; }
+// PQ subspaces for a dim: 8 floats per subspace (768-d -> m=96), or a
+// single subspace when dim is not a multiple of 8.
+std::size_t pq_subspaces(std::size_t dim) { return dim % 8 == 0 ? dim / 8 : 1; }
+std::size_t pq_row_bytes(std::size_t dim) { return pq_subspaces(dim); }
+std::size_t binary_row_bytes(std::size_t dim) { return (dim + 63) / 64 * sizeof(std::uint64_t); }
+std::size_t padded_row_bytes(std::size_t dim) {
+  return (dim + vecdb::kRowPad - 1) / vecdb::kRowPad * vecdb::kRowPad * sizeof(float);
+}
+
+float pass_l2_sq(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (const float* r : w.rows) s += k.l2_sq(w.query, r, w.dim);
+  return s;
+}
+
+float pass_dot(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (const float* r : w.rows) s += k.dot(w.query, r, w.dim);
+  return s;
+}
+
+float pass_l2_sq_bounded(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (const float* r : w.rows) s += k.l2_sq_bounded(w.query, r, w.dim, w.l2_bound);
+  return s;
+}
+
+bool has_fixed(const simd::Kernels& k, const Workload& w) { return k.find_fixed(w.dim) != nullptr; }
+
+float pass_l2_sq_fixed(const simd::Kernels& k, const Workload& w) {
+  const simd::KernelFn fn = k.find_fixed(w.dim)->l2_sq;
+  float s = 0.0f;
+  for (const float* r : w.rows) s += fn(w.query, r, w.dim);
+  return s;
+}
+
+float pass_dot_fixed(const simd::Kernels& k, const Workload& w) {
+  const simd::KernelFn fn = k.find_fixed(w.dim)->dot;
+  float s = 0.0f;
+  for (const float* r : w.rows) s += fn(w.query, r, w.dim);
+  return s;
+}
+
+// Cases that do not go through a level's kernel table (Distance's public
+// entry points, PQ table lookups) are timed once, at the active level.
+bool is_active(const simd::Kernels& k, const Workload&) { return k.level == simd::active().level; }
+
+// The per-call metric switch (distance()) against a function resolved once.
+
+float pass_distance_switch(const simd::Kernels&, const Workload& w) {
+  float s = 0.0f;
+  for (const float* r : w.rows) s += vecdb::Distance::distance(vecdb::Metric::L2, w.query, r, w.dim);
+  return s;
+}
+
+float pass_distance_resolved(const simd::Kernels&, const Workload& w) {
+  const vecdb::DistanceFn fn = vecdb::Distance::resolve(vecdb::Metric::L2, w.dim);
+  float s = 0.0f;
+  for (const float* r : w.rows) s += fn(w.query, r, w.dim, 1.0f, 1.0f);
+  return s;
+}
+
+float pass_cosine(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (std::size_t i = 0; i < w.rows.size(); ++i) {
+    s += k.cosine_dist(w.query, w.rows[i], w.dim, 1.0f, w.inv_rows[i]);
+  }
+  return s;
+}
+
+float pass_l2_aligned(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (const float* r : w.padded_rows) s += k.aligned.l2_dist(w.padded_query, r, w.stride, 1.0f, 1.0f);
+  return s;
+}
+
+// Half rows are widened in-register; the query stays float.
+template <simd::HalfKernels simd::Kernels::*Format, vecdb::HalfDistanceFn simd::HalfKernels::*Fn,
+          std::vector<const std::uint16_t*> Workload::*Rows>
+float pass_half(const simd::Kernels& k, const Workload& w) {
+  const vecdb::HalfDistanceFn fn = (k.*Format).*Fn;
+  const auto& rows = w.*Rows;
+  float s = 0.0f;
+  for (std::size_t i = 0; i < rows.size(); ++i) s += fn(w.query, rows[i], w.dim, 1.0f, w.inv_rows[i]);
+  return s;
+}
+
+float pass_sq8_l2(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (const std::uint8_t* c : w.codes) s += k.sq8_l2(w.query, w.sq8_scale, c, w.dim);
+  return s;
+}
+
+float pass_sq8_dot(const simd::Kernels& k, const Workload& w) {
+  float s = 0.0f;
+  for (const std::uint8_t* c : w.codes) s += k.sq8_dot(w.query, c, w.dim);
+  return s;
+}
+
+// ADC as a search runs it: one m x 256 table per query, then m lookups per
+// row. The table build is timed too, amortized over the pass.
+float pass_pq_adc(const simd::Kernels&, const Workload& w) {
+  const vecdb::ProductQuantizer::Table t = w.pq->prepare(vecdb::Metric::L2, w.query, 1.0f);
+  float s = 0.0f;
+  for (const std::uint8_t* c : w.pq_codes) s += w.pq->distance(t, c, 1.0f);
+  return s;
+}
+
+float pass_hamming(const simd::Kernels& k, const Workload& w) {
+  std::uint32_t s = 0;
+  for (const std::uint64_t* b : w.bits) s += k.hamming(w.query_bits, b, w.bit_words);
+  return static_cast<float>(s);
+}
+
+// Batched entry points, fed in chunks the size of an HNSW neighbor list.
+constexpr std::size_t kBatch = 32;
+
+template <vecdb::BatchDistanceFn simd::Kernels::*Fn>
+float pass_batch(const simd::Kernels& k, const Workload& w) {
+  float out[kBatch];
+  float s = 0.0f;
+  for (std::size_t i = 0; i < w.rows.size(); i += kBatch) {
+    const std::size_t n = std::min(kBatch, w.rows.size() - i);
+    (k.*Fn)(w.query, w.rows.data() + i, n, w.dim, 1.0f, w.inv_rows.data() + i, out);
+    for (std::size_t j = 0; j < n; ++j) s += out[j];
+  }
+  return s;
+}
+
+float pass_l2_batch_bounded(const simd::Kernels& k, const Workload& w) {
+  float out[kBatch];
+  float s = 0.0f;
+  for (std::size_t i = 0; i < w.rows.size(); i += kBatch) {
+    const std::size_t n = std::min(kBatch, w.rows.size() - i);
+    k.l2_batch_bounded(w.query, w.rows.data() + i, n, w.dim, w.l2_bound, out);
+    for (std::size_t j = 0; j < n; ++j) s += out[j];
+  }
+  return s;
+}
+
+float pass_l2_batch_fixed(const simd::Kernels& k, const Workload& w) {
+  const vecdb::BatchDistanceFn fn = k.find_fixed(w.dim)->l2_batch;
+  float out[kBatch];
+  float s = 0.0f;
+  for (std::size_t i = 0; i < w.rows.size(); i += kBatch) {
+    const std::size_t n = std::min(kBatch, w.rows.size() - i);
+    fn(w.query, w.rows.data() + i, n, w.dim, 1.0f, nullptr, out);
+    for (std::size_t j = 0; j < n; ++j) s += out[j];
+  }
+  return s;
+}
+
+const KernelCase kCases[] = {
+    {"l2_sq", &float_row_bytes, &pass_l2_sq},
+    {"dot", &float_row_bytes, &pass_dot},
+    {"cosine", &float_row_bytes, &pass_cosine},
+    {"l2_sq_bounded", &float_row_bytes, &pass_l2_sq_bounded},
+    {"l2_sq_fixed", &float_row_bytes, &pass_l2_sq_fixed, &has_fixed},
+    {"dot_fixed", &float_row_bytes, &pass_dot_fixed, &has_fixed},
+    {"distance_switch", &float_row_bytes, &pass_distance_switch, &is_active},
+    {"distance_resolved", &float_row_bytes, &pass_distance_resolved, &is_active},
+    {"l2_aligned", &padded_row_bytes, &pass_l2_aligned},
+    {"l2_batch", &float_row_bytes, &pass_batch<&simd::Kernels::l2_batch>},
+    {"l2_batch_bounded", &float_row_bytes, &pass_l2_batch_bounded},
+    {"l2_batch_fixed", &float_row_bytes, &pass_l2_batch_fixed, &has_fixed},
+    {"cosine_batch", &float_row_bytes, &pass_batch<&simd::Kernels::cosine_batch>},
+    {"f16_l2", &half_row_bytes,
+     &pass_half<&simd::Kernels::f16, &simd::HalfKernels::l2_dist, &Workload::f16_rows>},
+    {"f16_cosine", &half_row_bytes,
+     &pass_half<&simd::Kernels::f16, &simd::HalfKernels::cosine_dist, &Workload::f16_rows>},
+    {"bf16_l2", &half_row_bytes,
+     &pass_half<&simd::Kernels::bf16, &simd::HalfKernels::l2_dist, &Workload::bf16_rows>},
+    {"bf16_cosine", &half_row_bytes,
+     &pass_half<&simd::Kernels::bf16, &simd::HalfKernels::cosine_dist, &Workload::bf16_rows>},
+    {"sq8_l2", &sq8_row_bytes, &pass_sq8_l2},
+    {"sq8_dot", &sq8_row_bytes, &pass_sq8_dot},
+    {"pq_adc", &pq_row_bytes, &pass_pq_adc, &is_active},
+    {"hamming", &binary_row_bytes, &pass_hamming},
+};
+
+struct Options {
+  std::string format = "csv";
+  std::string out;
+  std::vector<std::size_t> dims = {16, 64, 128, 384, 768, 1024, 1536};
+  std::size_t cache_kb = 64;
+  std::size_t mem_mb = 128;
+  double min_ms = 20.0;
+  bool active_only = false;
+};
+
+struct Result {
+  std::string level;
+  std::string kernel;
+  std::size_t dim;
+  std::string working_set;
+  std::string order;
+  std::size_t rows;
+  std::size_t bytes_per_call;
+  double ns_per_call;
+  double gb_per_s;
+};
+
+std::vector<std::size_t> parse_dims(const std::string& s) {
+  std::vector<std::size_t> out;
+  std::stringstream ss(s);
+  std::string tok;
+  while (std::getline(ss, tok, ',')) {
+    if (!tok.empty()) out.push_back(static_cast<std::size_t>(std::stoul(tok)));
+  }
+  if (out.empty()) throw std::invalid_argument("--dims: empty list");
+  return out;
+}
+
+Options parse_options(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    auto value = [&]() -> std::string {
+      if (i + 1 >= argc) throw std::invalid_argument("missing value for " + a);
+      return argv[++i];
+    };
+    if (a == "--format") o.format = value();
+    else if (a == "--out") o.out = value();
+    else if (a == "--dims") o.dims = parse_dims(value());
+    else if (a == "--cache-kb") o.cache_kb = std::stoul(value());
+    else if (a == "--mem-mb") o.mem_mb = std::stoul(value());
+    else if (a == "--min-ms") o.min_ms = std::stod(value());
+    else if (a == "--active-only") o.active_only = true;
+    else throw std::invalid_argument("unknown option: " + a);
+  }
+  if (o.format != "csv" && o.format != "json") {
+    throw std::invalid_argument("--format must be csv or json");
+  }
+  return o;
+}
+
+// Runs whole passes until min_ms has elapsed (after one warm-up pass).
+double time_ns_per_call(const KernelCase& c, const simd::Kernels& k, const Workload& w,
+                        double min_ms, float& sink) {
+  sink += c.pass(k, w);
+  std::size_t calls = 0;
+  const auto t0 = Clock::now();
+  double elapsed_ms = 0.0;
+  do {
+    sink += c.pass(k, w);
+    calls += w.rows.size();
+    elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  } while (elapsed_ms < min_ms);
+  return elapsed_ms * 1e6 / static_cast<double>(calls);
+}
+
+void write_csv(std::ostream& os, const std::vector<Result>& results) {
+  os << "level,kernel,dim,working_set,order,rows,bytes_per_call,ns_per_call,gb_per_s\n";
+  for (const auto& r : results) {
+    os << r.level << ',' << r.kernel << ',' << r.dim << ',' << r.working_set << ','
+       << r.order << ',' << r.rows << ',' << r.bytes_per_call << ',' << std::fixed
+       << std::setprecision(3) << r.ns_per_call << ',' << r.gb_per_s << '\n';
+  }
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results) {
+  os << "{\n  \"active_level\": \"" << vecdb::Distance::simd_name() << "\",\n";
+  os << "  \"results\": [\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    os << "    {\"level\": \"" << r.level << "\", \"kernel\": \"" << r.kernel
+       << "\", \"dim\": " << r.dim << ", \"working_set\": \"" << r.working_set
+       << "\", \"order\": \"" << r.order << "\", \"rows\": " << r.rows
+       << ", \"bytes_per_call\": " << r.bytes_per_call << ", \"ns_per_call\": " << std::fixed
+       << std::setprecision(3) << r.ns_per_call << ", \"gb_per_s\": " << r.gb_per_s << "}"
+       << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  os << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  try {
+    opt = parse_options(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << "vecdb_bench_distance: " << e.what() << "\n";
+    return 2;
+  }
+
+  std::vector<simd::Level> levels;
+  const int top = static_cast<int>(simd::detect());
+  for (int l = opt.active_only ? top : 0; l <= top; ++l) {
+    levels.push_back(static_cast<simd::Level>(l));
+  }
+
+  // One large random buffer backs both working sets; the "cache" set is a
+  // prefix of it that is re-read on every pass.
+  const std::size_t max_dim = *std::max_element(opt.dims.begin(), opt.dims.end());
+  const std::size_t mem_floats = std::max(opt.mem_mb * 1024 * 1024 / sizeof(float), 2 * max_dim);
+  std::vector<float> buffer(mem_floats);
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> uni(-1.0f, 1.0f);
+  for (auto& x : buffer) x = uni(rng);
+
+  std::vector<Result> results;
+  float sink = 0.0f;
+
+  for (std::size_t dim : opt.dims) {
+    std::vector<float> query(dim);
+    for (auto& x : query) x = uni(rng);
+
+    const std::size_t mem_rows = mem_floats / dim;
+
+    // SQ8 codes for every row of the buffer (dim bytes each).
+    std::vector<const float*> train_rows;
+    for (std::size_t r = 0; r < std::min<std::size_t>(mem_rows, 4096); ++r) {
+      train_rows.push_back(buffer.data() + r * dim);
+    }
+    vecdb::ScalarQuantizer sq(dim);
+    sq.train(train_rows.data(), train_rows.size());
+    std::vector<std::uint8_t> codes(mem_rows * dim);
+    for (std::size_t r = 0; r < mem_rows; ++r) {
+      sq.encode(buffer.data() + r * dim, codes.data() + r * dim);
+    }
+    std::vector<std::uint16_t> f16(mem_rows * dim);
+    std::vector<std::uint16_t> bf16(mem_rows * dim);
+    for (std::size_t r = 0; r < mem_rows; ++r) {
+      vecdb::encode_half_row(vecdb::RowFormat::F16, buffer.data() + r * dim, dim, f16.data() + r * dim);
+      vecdb::encode_half_row(vecdb::RowFormat::BF16, buffer.data() + r * dim, dim, bf16.data() + r * dim);
+    }
+
+    // Codebook quality does not matter for timing; a short training run will do.
+    vecdb::ProductQuantizer pq(dim, pq_subspaces(dim));
+    pq.train(train_rows.data(), std::min<std::size_t>(train_rows.size(), 2048), /*iters=*/5);
+    std::vector<std::uint8_t> pq_codes(mem_rows * pq.m());
+    for (std::size_t r = 0; r < mem_rows; ++r) {
+      pq.encode(buffer.data() + r * dim, pq_codes.data() + r * pq.m());
+    }
+    vecdb::BinaryQuantizer bq(dim);
+    std::vector<std::uint64_t> bits(mem_rows * bq.words());
+    for (std::size_t r = 0; r < mem_rows; ++r) {
+      bq.encode(buffer.data() + r * dim, bits.data() + r * bq.words());
+    }
+    std::vector<std::uint64_t> query_bits(bq.words());
+    bq.encode(query.data(), query_bits.data());
+
+    const std::size_t stride = padded_row_bytes(dim) / sizeof(float);
+    vecdb::AlignedVector<float> padded(mem_rows * stride, 0.0f);
+    for (std::size_t r = 0; r < mem_rows; ++r) {
+      std::copy(buffer.data() + r * dim, buffer.data() + (r + 1) * dim, padded.data() + r * stride);
+    }
+    vecdb::AlignedVector<float> padded_query(stride, 0.0f);
+    std::copy(query.begin(), query.end(), padded_query.begin());
+
+    const std::size_t cache_rows =
+        std::min(mem_rows, std::max<std::size_t>(1, opt.cache_kb * 1024 / (dim * sizeof(float))));
+
+    struct Set {
+      const char* working_set;
+      const char* order;
+      std::size_t rows;
+      bool shuffle;
+    };
+    const Set sets[] = {
+        {"cache", "seq", cache_rows, false},
+        {"mem", "seq", mem_rows, false},
+        {"mem", "rand", mem_rows, true},
+    };
+
+    for (const Set& set : sets) {
+      Workload w;
+      w.dim = dim;
+      w.query = query.data();
+      w.sq8_scale = sq.scale().data();
+      w.pq = &pq;
+      w.query_bits = query_bits.data();
+      w.bit_words = bq.words();
+      w.stride = stride;
+      w.padded_query = padded_query.data();
+      std::vector<std::size_t> order(set.rows);
+      std::iota(order.begin(), order.end(), std::size_t{0});
+      if (set.shuffle) std::shuffle(order.begin(), order.end(), rng);
+      w.rows.reserve(set.rows);
+      w.inv_rows.reserve(set.rows);
+      w.codes.reserve(set.rows);
+      w.pq_codes.reserve(set.rows);
+      w.f16_rows.reserve(set.rows);
+      w.bf16_rows.reserve(set.rows);
+      w.bits.reserve(set.rows);
+      for (std::size_t r : order) {
+        const float* p = buffer.data() + r * dim;
+        w.rows.push_back(p);
+        w.inv_rows.push_back(vecdb::Distance::inv_norm(p, dim));
+        w.codes.push_back(codes.data() + r * dim);
+        w.pq_codes.push_back(pq_codes.data() + r * pq.m());
+        w.f16_rows.push_back(f16.data() + r * dim);
+        w.bf16_rows.push_back(bf16.data() + r * dim);
+        w.bits.push_back(bits.data() + r * bq.words());
+        w.padded_rows.push_back(padded.data() + r * stride);
+      }
+      {
+        const std::size_t n = std::min<std::size_t>(w.rows.size(), 4096);
+        std::vector<float> d(n);
+        for (std::size_t i = 0; i < n; ++i) d[i] = vecdb::Distance::l2_sq(w.query, w.rows[i], dim);
+        std::nth_element(d.begin(), d.begin() + n / 100, d.end());
+        w.l2_bound = d[n / 100];
+      }
+
+      for (simd::Level level : levels) {
+        const simd::Kernels& k = simd::kernels(level);
+        for (const KernelCase& c : kCases) {
+          if (c.applies && !c.applies(k, w)) continue;
+          const double ns = time_ns_per_call(c, k, w, opt.min_ms, sink);
+          const std::size_t bytes = c.bytes_per_row(dim);
+          results.push_back({k.name, c.name, dim, set.working_set, set.order, set.rows, bytes,
+                             ns, static_cast<double>(bytes) / ns});
+        }
+      }
+    }
+  }
+
+  std::ofstream file;
+  if (!opt.out.empty()) {
+    file.open(opt.out);
+    if (!file) {
+      std::cerr << "vecdb_bench_distance: cannot open " << opt.out << "\n";
+      return 1;
+    }
+  }
+  std::ostream& os = opt.out.empty() ? std::cout : file;
+  if (opt.format == "json") write_json(os, results);
+  else write_csv(os, results);
+
+  // Keeps the kernel results observable; printed to stderr so the report stays clean.
+  std::cerr << "checksum " << sink << "\n";
+  return 0;
+}
@@ -10,6 +10,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "vecdb/Bruteforce.h"
 #include "vecdb/Collection.h"
 #include "vecdb/Csv.h"
 #include "vecdb/Distance.h"
@@ -109,7 +110,16 @@ static float get_float_or(const Args& a, const std::string& k, float def) {
 static vecdb::Metric parse_metric(const std::string& s) {
   if (s == "l2" || s == "L2") return vecdb::Metric::L2;
   if (s == "cosine" || s == "COSINE") return vecdb::Metric::COSINE;
-  throw std::invalid_argument("unknown metric: " + s + " (use l2|cosine)");
+  if (s == "ip" || s == "IP") return vecdb::Metric::IP;
+  throw std::invalid_argument("unknown metric: " + s + " (use l2|cosine|ip)");
+}
+
+static const char* metric_name(vecdb::Metric m) {
+  switch (m) {
+    case vecdb::Metric::COSINE: return "cosine";
+    case vecdb::Metric::IP: return "ip";
+    default: return "l2";
+  }
 }
 
 static bool parse_metadata_kv(const std::string& s, vecdb::Metadata& out, std::string& err) {
@@ -151,7 +161,7 @@ CSV FORMATS:
 
 COMMON OPTIONS:
   --dir <path>          Collection directory (e.g., data/mycol)
-  --metric l2|cosine    Metric (default l2)
+  --metric l2|cosine|ip Metric (default l2; ip = max inner product)
   --header              CSV has a header row (skip first row)
   --has-id              CSV first column is id (even if numeric)
   --meta                CSV has a trailing metadata column
@@ -164,14 +174,24 @@ create OPTIONS:
   --diversity 0|1       Neighbor diversity heuristic (default 1)
   --seed <n>            RNG seed (default 123)
   --level_mult <f>      Level multiplier (default 1.0)
+  --normalize           L2-normalize vectors on ingest (cosine runs as 1 - dot;
+                        requires --metric cosine)
+  --sq8                 Search HNSW on 8-bit codes, rerank exactly (4x less traffic)
+  --pq <m>              Search HNSW on m-byte PQ codes, rerank exactly (m divides dim)
+  --binary <n>          Scan 1-bit sign codes by Hamming, rerank best n exactly (no index)
+  --rows <f32|f16|bf16> Element type of stored rows (default f32; half formats halve RAM)
+  --pad                 Pad f32 rows to 16-float cache-line strides (aligned kernels)
 
 load OPTIONS:
   --csv <file>          vectors.csv path (required)
-  --build 0|1           build index after load (default 0)
+  --build 0|1           rebuild the index after load instead of linking rows
+                        into the current one as they land (default 0)
+  --threads <n>         with --build: link nodes on n threads (default 1)
   --meta                vectors.csv has trailing metadata column (key=value;key2=value2)
 
 build OPTIONS:
   (same HNSW params as create; overrides manifest params before building)
+  --threads <n>         Link nodes on n threads (default 1; 0 = all cores)
 
 search OPTIONS:
   --query <csvline>     Single query line: f1,f2,...,f_dim  (no id)
@@ -193,32 +213,6 @@ EXAMPLES:
 
 // ---------------- Demo / benchmark (kept) ----------------
 
-static std::vector<std::pair<std::size_t, float>> bruteforce_topk(
-    const vecdb::VectorStore& store,
-    vecdb::Metric metric,
-    const std::vector<float>& query,
-    std::size_t k) {
-
-  std::vector<std::pair<std::size_t, float>> all;
-  all.reserve(store.size());
-
-  for (std::size_t i = 0; i < store.size(); ++i) {
-    if (!store.is_alive(i)) continue;
-    const float* p = store.get_ptr(i);
-    if (!p) continue;
-    float d = vecdb::Distance::distance(metric, query.data(), p, store.dim());
-    all.push_back({i, d});
-  }
-
-  if (k > all.size()) k = all.size();
-  std::nth_element(all.begin(), all.begin() + k, all.end(),
-                   [](auto& a, auto& b) { return a.second < b.second; });
-  all.resize(k);
-  std::sort(all.begin(), all.end(),
-            [](auto& a, auto& b) { return a.second < b.second; });
-  return all;
-}
-
 static double recall_at_k(const std::vector<std::vector<std::size_t>>& truth,
                           const std::vector<std::vector<std::size_t>>& approx) {
   std::size_t hit = 0;
@@ -249,11 +243,10 @@ static void run_hnsw_benchmark() {
 
   std::vector<std::vector<std::size_t>> truth;
   truth.reserve(queries);
-  for (std::size_t qi = 0; qi < queries; ++qi) {
-    auto top = bruteforce_topk(store, vecdb::Metric::L2, Q[qi], k);
+  for (const auto& top : vecdb::Bruteforce(store, vecdb::Metric::L2).search_batch(Q, k)) {
     std::vector<std::size_t> ids;
     ids.reserve(top.size());
-    for (auto& p : top) ids.push_back(p.first);
+    for (auto& r : top) ids.push_back(r.index);
     truth.push_back(std::move(ids));
   }
 
@@ -359,6 +352,7 @@ static int run_demo() {
   std::cout << std::fixed << std::setprecision(6);
   std::cout << "VecDB MVP starting...\n";
   std::cout << "Platform: " << platform_name() << "\n";
+  std::cout << "SIMD: " << vecdb::Distance::simd_name() << "\n";
 
   // Distance sanity checks
   {
@@ -463,11 +457,32 @@ static int cmd_create(const Args& a) {
   opt.dim = dim;
   opt.metric = parse_metric(metric_s);
   opt.hnsw_params = read_hnsw_params_from_args(a);
+  opt.normalize = has_flag(a, "--normalize");
+  if (opt.normalize && opt.metric != vecdb::Metric::COSINE) {
+    std::cerr << "create: --normalize requires --metric cosine\n";
+    return 2;
+  }
+  opt.sq8 = has_flag(a, "--sq8");
+  opt.pq_m = get_size_or(a, "--pq", 0);
+  opt.binary_shortlist = get_size_or(a, "--binary", 0);
+  std::string rows_s;
+  if (get_kv(a, "--rows", rows_s)) opt.row_format = vecdb::row_format_from_string(rows_s);
+  opt.pad_rows = has_flag(a, "--pad");
 
   auto col = vecdb::Collection::create(dir, opt);
   std::cout << "Created collection at: " << col.dir()
             << " dim=" << col.dim()
             << " metric=" << metric_s
+            << (col.normalized() ? " normalize=1" : "")
+            << (col.quantized() ? " sq8=1" : "")
+            << (col.pq_subspaces() > 0 ? " pq=" + std::to_string(col.pq_subspaces()) : "")
+            << (col.binary_shortlist() > 0
+                    ? " binary=" + std::to_string(col.binary_shortlist())
+                    : "")
+            << (col.row_format() != vecdb::RowFormat::F32
+                    ? std::string(" rows=") + vecdb::row_format_to_string(col.row_format())
+                    : "")
+            << (col.padded_rows() ? " pad=1" : "")
             << "\n";
   return 0;
 }
@@ -481,12 +496,41 @@ static int cmd_load(const Args& a) {
 
   auto col = vecdb::Collection::open(dir);
 
+  // With --build the index is rebuilt from scratch afterwards, so keeping the
+  // current one live during ingest would only link every row twice.
+  const int build = get_int_or(a, "--build", 0);
+  if (build != 0) {
+    col.drop_index();
+    std::string threads;
+    if (get_kv(a, "--threads", threads)) {
+      vecdb::Hnsw::Params p = col.hnsw_params();
+      p.build_threads = static_cast<std::size_t>(get_size_or(a, "--threads", 1));
+      col.set_hnsw_params(p);
+    }
+  }
+
   vecdb::csv::Options opt;
   opt.has_header = has_flag(a, "--header");
   opt.has_id = true;       // load requires id as first column
   opt.infer_id = false;
   opt.allow_metadata = has_flag(a, "--meta");
 
+  // Rows are buffered and handed to upsert_batch() a chunk at a time, so the
+  // collection lock and capacity growth are paid per chunk, not per row.
+  constexpr std::size_t kChunk = 4096;
+  std::vector<std::string> ids;
+  std::vector<float> vecs;
+  std::vector<vecdb::Metadata> metas;
+  ids.reserve(kChunk);
+  vecs.reserve(kChunk * col.dim());
+  if (opt.allow_metadata) metas.reserve(kChunk);
+  auto flush = [&]() {
+    col.upsert_batch(ids, vecs, std::move(metas));
+    ids.clear();
+    vecs.clear();
+    metas.clear();
+  };
+
   std::size_t inserted = 0;
   std::string err;
   bool ok = vecdb::csv::for_each_row(csv_path, col.dim(),
@@ -495,38 +539,43 @@ static int cmd_load(const Args& a) {
         std::cerr << "load: vectors.csv must contain id as first column: id,f1,...,f_dim\n";
         return false;
       }
-      vecdb::Metadata meta;
       if (opt.allow_metadata) {
         if (!row.has_metadata) {
           std::cerr << "load: --meta enabled but row has no metadata column\n";
           return false;
         }
+        vecdb::Metadata meta;
         std::string merr;
         if (!parse_metadata_kv(row.metadata_raw, meta, merr)) {
           std::cerr << "load: metadata parse error: " << merr << "\n";
           return false;
         }
+        metas.push_back(std::move(meta));
       }
-      col.upsert(row.id, row.vec, meta);
+      ids.push_back(row.id);
+      vecs.insert(vecs.end(), row.vec.begin(), row.vec.end());
+      if (ids.size() == kChunk) flush();
       ++inserted;
       return true;
     }, err, opt);
+  if (ok && !ids.empty()) flush();
 
   if (!ok) {
     std::cerr << "load failed: " << err << "\n";
     return 2;
   }
 
-  // After loading, index is invalidated; save store + manifest (and remove hnsw.bin if existed).
-  col.save();
   std::cout << "Loaded vectors: " << inserted << " into " << dir << "\n";
-
-  int build = get_int_or(a, "--build", 0);
   if (build != 0) {
     col.build_index();
     col.save();
     std::cout << "Index built and saved.\n";
+    return 0;
   }
+
+  // Rows were linked into the index (if one was built) as they landed; save
+  // store + manifest + graph.
+  col.save();
   return 0;
 }
 
@@ -550,6 +599,11 @@ static int cmd_build(const Args& a) {
   if (has_any_param) {
     col.set_hnsw_params(read_hnsw_params_from_args(a));
   }
+  if (get_kv(a, "--threads", metric_s)) {
+    vecdb::Hnsw::Params p = col.hnsw_params();
+    p.build_threads = static_cast<std::size_t>(get_size_or(a, "--threads", 1));
+    col.set_hnsw_params(p);
+  }
 
   std::cout << "Building index for dir=" << dir << " (alive=" << col.alive_count() << ")\n";
   col.build_index();
@@ -591,7 +645,7 @@ static int cmd_search(const Args& a) {
   }
 
   auto col = vecdb::Collection::open(dir);
-  if (!col.has_index() && filter.empty()) {
+  if (!col.has_index() && filter.empty() && col.binary_shortlist() == 0) {
     std::cerr << "search: index not found. Run: vecdb build --dir " << dir << "\n";
     return 2;
   }
@@ -676,7 +730,13 @@ static int cmd_stats(const Args& a) {
 
   std::cout << "Collection dir: " << col.dir() << "\n";
   std::cout << "dim: " << col.dim() << "\n";
-  std::cout << "metric: " << (col.metric() == vecdb::Metric::L2 ? "l2" : "cosine") << "\n";
+  std::cout << "metric: " << metric_name(col.metric()) << "\n";
+  std::cout << "normalized: " << (col.normalized() ? "true" : "false") << "\n";
+  std::cout << "sq8: " << (col.quantized() ? "true" : "false") << "\n";
+  std::cout << "pq_m: " << col.pq_subspaces() << "\n";
+  std::cout << "binary_shortlist: " << col.binary_shortlist() << "\n";
+  std::cout << "row_format: " << vecdb::row_format_to_string(col.row_format()) << "\n";
+  std::cout << "pad_rows: " << (col.padded_rows() ? "true" : "false") << "\n";
   std::cout << "size(slots): " << col.size() << "\n";
   std::cout << "alive: " << col.alive_count() << "\n";
   std::cout << "has_index: " << (col.has_index() ? "true" : "false") << "\n";
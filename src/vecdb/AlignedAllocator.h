@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace vecdb {
+
+// Cache line size assumed for row layout (x86 and most ARM cores).
+constexpr std::size_t kCacheLine = 64;
+
+// Row stride granularity of padded stores, in floats: one cache line, and a
+// whole number of SSE / AVX / AVX-512 registers.
+constexpr std::size_t kRowPad = kCacheLine / sizeof(float);
+
+// Minimal std::allocator replacement whose storage starts on an Align-byte
+// boundary (C++17 aligned operator new).
+template <class T, std::size_t Align = kCacheLine>
+struct AlignedAllocator {
+  static_assert(Align >= alignof(T) && (Align & (Align - 1)) == 0,
+                "AlignedAllocator: Align must be a power of two >= alignof(T)");
+
+  using value_type = T;
+
+  template <class U>
+  struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() noexcept = default;
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Align}));
+  }
+  void deallocate(T* p, std::size_t) noexcept {
+    ::operator delete(p, std::align_val_t{Align});
+  }
+
+  template <class U>
+  bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+  template <class U>
+  bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+};
+
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+}  // namespace vecdb
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ReserveGeometric.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace vecdb {
+
+// Packed per-slot alive flags (1 bit per slot) with a maintained count of
+// set bits, so live_count() is O(1). for_each() walks a range one 64-bit word
+// at a time and jumps straight to set bits, so scans over a store with many
+// tombstones skip dead slots 64 at a time instead of testing each one.
+class AliveBitset {
+ public:
+  // Slots tracked (alive or dead).
+  std::size_t size() const { return size_; }
+
+  // Slots whose bit is set.
+  std::size_t live_count() const { return live_; }
+
+  // Precondition: i < size().
+  bool test(std::size_t i) const {
+    return (words_[i >> 6] >> (i & 63)) & 1u;
+  }
+
+  // Precondition: i < size(). Setting an already-set bit (or resetting a
+  // clear one) leaves the count unchanged.
+  void set(std::size_t i) {
+    std::uint64_t& w = words_[i >> 6];
+    const std::uint64_t bit = std::uint64_t{1} << (i & 63);
+    if (!(w & bit)) {
+      w |= bit;
+      ++live_;
+    }
+  }
+  void reset(std::size_t i) {
+    std::uint64_t& w = words_[i >> 6];
+    const std::uint64_t bit = std::uint64_t{1} << (i & 63);
+    if (w & bit) {
+      w &= ~bit;
+      --live_;
+    }
+  }
+
+  // Appends slot size() with the given state.
+  void push_back(bool alive) {
+    if ((size_ & 63) == 0) words_.push_back(0);
+    ++size_;
+    if (alive) set(size_ - 1);
+  }
+
+  void reserve(std::size_t n) {
+    reserve_geometric(words_, (n + 63) >> 6);
+  }
+
+  void clear() {
+    words_.clear();
+    size_ = 0;
+    live_ = 0;
+  }
+
+  // Replaces the contents with one flag per byte (non-zero = alive), the
+  // layout of alive.bin.
+  void assign(const std::vector<std::uint8_t>& flags) {
+    words_.assign((flags.size() + 63) >> 6, 0);
+    size_ = flags.size();
+    live_ = 0;
+    for (std::size_t i = 0; i < flags.size(); ++i) {
+      if (flags[i]) {
+        words_[i >> 6] |= std::uint64_t{1} << (i & 63);
+        ++live_;
+      }
+    }
+  }
+
+  // Calls f(i) for every set bit i in [begin, end), in increasing order.
+  // Precondition: end <= size().
+  template <class F>
+  void for_each(std::size_t begin, std::size_t end, F&& f) const {
+    if (begin >= end) return;
+    const std::size_t last = (end - 1) >> 6;
+    for (std::size_t wi = begin >> 6; wi <= last; ++wi) {
+      std::uint64_t w = words_[wi];
+      if (wi == (begin >> 6)) w &= ~std::uint64_t{0} << (begin & 63);
+      if (wi == last && (end & 63) != 0) w &= ~(~std::uint64_t{0} << (end & 63));
+      while (w) {
+        f((wi << 6) + ctz64_(w));
+        w &= w - 1;
+      }
+    }
+  }
+
+  template <class F>
+  void for_each(F&& f) const {
+    for_each(0, size_, f);
+  }
+
+ private:
+  static unsigned ctz64_(std::uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long r;
+    _BitScanForward64(&r, x);
+    return static_cast<unsigned>(r);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+  }
+
+  std::vector<std::uint64_t> words_;
+  std::size_t size_ = 0;
+  std::size_t live_ = 0;
+};
+
+}  // namespace vecdb
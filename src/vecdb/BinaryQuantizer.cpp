@@ -0,0 +1,22 @@
+#include "BinaryQuantizer.h"
+
+#include "DistanceSimd.h"
+
+namespace vecdb {
+
+BinaryQuantizer::BinaryQuantizer(std::size_t dim)
+    : dim_(dim), words_((dim + 63) / 64), hamming_(simd::active().hamming) {}
+
+void BinaryQuantizer::encode(const float* v, std::uint64_t* out) const {
+  for (std::size_t w = 0; w < words_; ++w) {
+    const std::size_t base = w * 64;
+    const std::size_t n = dim_ - base < 64 ? dim_ - base : 64;
+    std::uint64_t bits = 0;
+    for (std::size_t t = 0; t < n; ++t) {
+      bits |= static_cast<std::uint64_t>(v[base + t] > 0.0f) << t;
+    }
+    out[w] = bits;
+  }
+}
+
+}  // namespace vecdb
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vecdb {
+
+// 1-bit codes: each dimension keeps only its sign (bit set when v[d] > 0),
+// packed into 64-bit words, so a row shrinks from 4*dim to dim/8 bytes.
+// Two codes are compared by Hamming distance (popcount of the XOR), which
+// tracks the angle between the original vectors. That makes the codes a
+// cheap first-pass filter for COSINE; reported distances come from an exact
+// rerank (see Bruteforce::search_binary()).
+//
+// There is nothing to train, so the codec is usable as soon as dim is known.
+class BinaryQuantizer {
+ public:
+  BinaryQuantizer() = default;
+  explicit BinaryQuantizer(std::size_t dim);
+
+  std::size_t dim() const { return dim_; }
+  std::size_t words() const { return words_; }  // uint64 words per code
+
+  // Pack the sign bits of one row into words() words (padding bits are 0).
+  void encode(const float* v, std::uint64_t* out) const;
+
+  // Number of differing bits between two codes.
+  std::uint32_t hamming(const std::uint64_t* a, const std::uint64_t* b) const {
+    return hamming_(a, b, words_);
+  }
+
+ private:
+  std::size_t dim_ = 0;
+  std::size_t words_ = 0;
+
+  // POPCNT kernel for the level selected at startup.
+  std::uint32_t (*hamming_)(const std::uint64_t* a, const std::uint64_t* b,
+                            std::size_t words) = nullptr;
+};
+
+}  // namespace vecdb
@@ -1,8 +1,10 @@
 #include "Bruteforce.h"
 
 #include <algorithm>
+#include <atomic>
 #include <queue>
 #include <stdexcept>
+#include <thread>
 
 namespace vecdb {
 
@@ -22,44 +24,302 @@ struct WorseFirst {
   }
 };
 
-std::vector<SearchResult> Bruteforce::search(const std::vector<float>& query, std::size_t k) const {
+using TopKHeap = std::priority_queue<HeapEntry, std::vector<HeapEntry>, WorseFirst>;
+
+static void push_topk(TopKHeap& heap, std::size_t k, std::size_t index, float d) {
+  if (heap.size() < k) {
+    heap.push({index, d});
+  } else if (d < heap.top().distance) {
+    heap.pop();
+    heap.push({index, d});
+  }
+}
+
+// Empties the heap into a vector sorted ascending by distance.
+static std::vector<SearchResult> drain_sorted(TopKHeap& heap) {
+  std::vector<SearchResult> results;
+  results.reserve(heap.size());
+  while (!heap.empty()) {
+    auto e = heap.top();
+    heap.pop();
+    results.push_back({e.index, e.distance});
+  }
+
+  std::sort(results.begin(), results.end(),
+            [](const SearchResult& a, const SearchResult& b) {
+              return a.distance < b.distance;
+            });
+
+  return results;
+}
+
+std::vector<SearchResult> Bruteforce::search(VectorView query, std::size_t k) const {
   if (query.size() != store_.dim()) {
     throw std::invalid_argument("Bruteforce::search: query dim mismatch");
   }
   if (k == 0) return {};
 
-  std::priority_queue<HeapEntry, std::vector<HeapEntry>, WorseFirst> heap;
+  TopKHeap heap;
 
-  for (std::size_t i = 0; i < store_.size(); ++i) {
-    if (!store_.is_alive(i)) continue;
-    const float* v = store_.get_ptr(i);
-    if (!v) continue;
+  const float q_inv = uses_norms_ ? Distance::inv_norm(query.data(), store_.dim()) : 1.0f;
+  // Float kernels run over row_stride() elements (see VectorStore::aligned_query).
+  AlignedVector<float> q_buf;
+  const float* q = store_.aligned_query(query.data(), q_buf);
+  const std::size_t stride = store_.row_stride();
 
-    float d = Distance::distance(metric_, query.data(), v, store_.dim());
+  // Scan in fixed-size blocks of slots: collect the live rows of a block, score
+  // them with one batched kernel call, then feed the heap.
+  constexpr std::size_t kBlock = 64;
+  std::size_t idx[kBlock];
+  const float* rows[kBlock];
+  float inv[kBlock];
+  float dist[kBlock];
 
-    if (heap.size() < k) {
-      heap.push({i, d});
-    } else if (d < heap.top().distance) {
-      heap.pop();
-      heap.push({i, d});
+  const std::size_t N = store_.size();
+  for (std::size_t base = 0; base < N; base += kBlock) {
+    const std::size_t end = std::min(N, base + kBlock);
+    std::size_t n = 0;
+    store_.alive().for_each(base, end, [&](std::size_t i) {
+      idx[n] = i;
+      if (!half_dist_) rows[n] = store_.row_ptr(i);
+      if (uses_norms_) inv[n] = store_.inv_norm(i);
+      ++n;
+    });
+    if (n == 0) continue;
+
+    if (half_dist_) {
+      // Half rows are widened inside the kernel, one row per call.
+      for (std::size_t j = 0; j < n; ++j) {
+        dist[j] = half_dist_(query.data(), store_.half_row_ptr(idx[j]), store_.dim(), q_inv,
+                             uses_norms_ ? inv[j] : 1.0f);
+      }
+    } else if (bounded_dist_ && heap.size() >= k) {
+      // Once the heap is full, rows are scored against the current worst and
+      // the kernel may give up part way through (see BoundedBatchDistanceFn).
+      bounded_dist_(q, rows, n, stride, heap.top().distance, dist);
+    } else {
+      batch_dist_(q, rows, n, stride, q_inv, uses_norms_ ? inv : nullptr, dist);
     }
+
+    for (std::size_t j = 0; j < n; ++j) push_topk(heap, k, idx[j], dist[j]);
   }
 
-  // Extract heap to vector (currently unordered), then sort ascending by distance
-  std::vector<SearchResult> results;
-  results.reserve(heap.size());
-  while (!heap.empty()) {
-    auto e = heap.top();
-    heap.pop();
-    results.push_back({e.index, e.distance});
+  return drain_sorted(heap);
+}
+
+std::vector<SearchResult> Bruteforce::search_pq(VectorView query,
+                                                std::size_t k,
+                                                std::size_t rerank) const {
+  if (query.size() != store_.dim()) {
+    throw std::invalid_argument("Bruteforce::search_pq: query dim mismatch");
+  }
+  if (!store_.has_pq()) throw std::logic_error("Bruteforce::search_pq: store has no PQ codes");
+  if (k == 0) return {};
+
+  const float q_inv = uses_norms_ ? Distance::inv_norm(query.data(), store_.dim()) : 1.0f;
+  const ProductQuantizer& pq = store_.pq();
+  const ProductQuantizer::Table table = pq.prepare(metric_, query.data(), q_inv);
+
+  const std::size_t shortlist = std::max(k, rerank);
+  TopKHeap heap;
+  store_.alive().for_each([&](std::size_t i) {
+    const float code_inv = uses_norms_ ? store_.inv_norm(i) : 1.0f;
+    push_topk(heap, shortlist, i, pq.distance(table, store_.pq_code(i), code_inv));
+  });
+
+  std::vector<SearchResult> results = drain_sorted(heap);
+  if (rerank > 0) {
+    AlignedVector<float> q_buf;
+    rerank_exact(store_.aligned_query(query.data(), q_buf), q_inv, results);
   }
+  if (results.size() > k) results.resize(k);
+  return results;
+}
+
+std::vector<SearchResult> Bruteforce::search_binary(VectorView query,
+                                                    std::size_t k,
+                                                    std::size_t shortlist) const {
+  if (query.size() != store_.dim()) {
+    throw std::invalid_argument("Bruteforce::search_binary: query dim mismatch");
+  }
+  if (!store_.has_binary()) {
+    throw std::logic_error("Bruteforce::search_binary: store has no binary codes");
+  }
+  if (k == 0) return {};
+
+  const BinaryQuantizer& bq = store_.binary();
+  std::vector<std::uint64_t> qcode(bq.words());
+  bq.encode(query.data(), qcode.data());
 
+  // Hamming distances are small integers, so they go through the same float
+  // heap exactly.
+  const std::size_t keep = std::max(k, shortlist);
+  TopKHeap heap;
+  store_.alive().for_each([&](std::size_t i) {
+    push_topk(heap, keep, i, static_cast<float>(bq.hamming(qcode.data(), store_.binary_code(i))));
+  });
+
+  std::vector<SearchResult> results = drain_sorted(heap);
+  const float q_inv = uses_norms_ ? Distance::inv_norm(query.data(), store_.dim()) : 1.0f;
+  AlignedVector<float> q_buf;
+  rerank_exact(store_.aligned_query(query.data(), q_buf), q_inv, results);
+  if (results.size() > k) results.resize(k);
+  return results;
+}
+
+void Bruteforce::rerank_exact(const float* query, float q_inv,
+                              std::vector<SearchResult>& results) const {
+  if (results.empty()) return;
+  if (half_dist_) {
+    for (auto& r : results) {
+      r.distance = half_dist_(query, store_.half_row_ptr(r.index), store_.dim(), q_inv,
+                              uses_norms_ ? store_.inv_norm(r.index) : 1.0f);
+    }
+    std::sort(results.begin(), results.end(),
+              [](const SearchResult& a, const SearchResult& b) {
+                return a.distance < b.distance;
+              });
+    return;
+  }
+  std::vector<const float*> rows(results.size());
+  std::vector<float> inv(uses_norms_ ? results.size() : 0);
+  std::vector<float> dist(results.size());
+  for (std::size_t j = 0; j < results.size(); ++j) {
+    rows[j] = store_.row_ptr(results[j].index);
+    if (uses_norms_) inv[j] = store_.inv_norm(results[j].index);
+  }
+  batch_dist_(query, rows.data(), rows.size(), store_.row_stride(), q_inv,
+              uses_norms_ ? inv.data() : nullptr, dist.data());
+  for (std::size_t j = 0; j < results.size(); ++j) results[j].distance = dist[j];
   std::sort(results.begin(), results.end(),
             [](const SearchResult& a, const SearchResult& b) {
               return a.distance < b.distance;
             });
+}
 
-  return results;
+std::vector<std::vector<SearchResult>> Bruteforce::search_batch(
+    const std::vector<std::vector<float>>& queries, std::size_t k, std::size_t threads) const {
+  const std::size_t dim = store_.dim();
+  for (const auto& q : queries) {
+    if (q.size() != dim) {
+      throw std::invalid_argument("Bruteforce::search_batch: query dim mismatch");
+    }
+  }
+
+  std::vector<std::vector<SearchResult>> out(queries.size());
+  if (k == 0 || queries.empty()) return out;
+
+  const std::size_t N = store_.size();
+  const bool l2 = (metric_ == Metric::L2);
+
+  // L2 is scored as ||q||^2 + ||x||^2 - 2 q.x: the IP kernel yields -q.x and
+  // the squared norms are computed once here instead of once per query.
+  // Queries are used as given, so kernels cover the logical dim (a prefix of
+  // each padded row) rather than row_stride().
+  const BatchDistanceFn kernel = Distance::resolve_batch(l2 ? Metric::IP : metric_, dim);
+  // Half rows are widened a tile at a time into a per-worker buffer, so the
+  // kernels below always see float rows.
+  const bool half = store_.half_rows();
+  std::vector<float> row_sq;
+  if (l2) {
+    std::vector<float> scratch(half ? dim : 0);
+    row_sq.assign(N, 0.0f);
+    store_.alive().for_each([&](std::size_t i) {
+      const float* x = store_.row_f32(i, scratch.data());
+      row_sq[i] = Distance::dot(x, x, dim);
+    });
+  }
+
+  // Per-query term: ||q||^2 for L2, 1/||q|| for COSINE.
+  std::vector<float> q_term(queries.size(), 1.0f);
+  for (std::size_t qi = 0; qi < queries.size(); ++qi) {
+    const float* q = queries[qi].data();
+    if (l2) q_term[qi] = Distance::dot(q, q, dim);
+    else if (uses_norms_) q_term[qi] = Distance::inv_norm(q, dim);
+  }
+
+  // A tile of rows (~256 KiB) stays in L2 while every query of a query tile is
+  // scored against it. Each worker claims whole query tiles, so the top-k heaps
+  // are private and need no locking.
+  constexpr std::size_t kQueryTile = 32;
+  const std::size_t row_tile = std::max<std::size_t>(64, (256 * 1024) / (dim * sizeof(float)));
+  const std::size_t num_tiles = (queries.size() + kQueryTile - 1) / kQueryTile;
+  const DistanceFn exact = Distance::resolve(metric_, dim);
+
+  std::atomic<std::size_t> next_tile{0};
+  auto worker = [&]() {
+    std::vector<std::size_t> idx;
+    std::vector<const float*> rows;
+    std::vector<float> inv;
+    std::vector<float> sq;
+    std::vector<float> dist;
+    std::vector<float> tile_buf(half ? row_tile * dim : 0);
+    std::vector<float> scratch(half ? dim : 0);
+    std::vector<TopKHeap> heaps(kQueryTile);
+
+    for (std::size_t t = next_tile++; t < num_tiles; t = next_tile++) {
+      const std::size_t q0 = t * kQueryTile;
+      const std::size_t q1 = std::min(queries.size(), q0 + kQueryTile);
+
+      for (std::size_t base = 0; base < N; base += row_tile) {
+        const std::size_t end = std::min(N, base + row_tile);
+        idx.clear();
+        rows.clear();
+        inv.clear();
+        sq.clear();
+        store_.alive().for_each(base, end, [&](std::size_t i) {
+          idx.push_back(i);
+          rows.push_back(half ? store_.row_f32(i, tile_buf.data() + (i - base) * dim)
+                              : store_.row_ptr(i));
+          if (uses_norms_) inv.push_back(store_.inv_norm(i));
+          if (l2) sq.push_back(row_sq[i]);
+        });
+        if (idx.empty()) continue;
+        dist.resize(idx.size());
+
+        for (std::size_t qi = q0; qi < q1; ++qi) {
+          kernel(queries[qi].data(), rows.data(), idx.size(), dim, q_term[qi],
+                 uses_norms_ ? inv.data() : nullptr, dist.data());
+          TopKHeap& heap = heaps[qi - q0];
+          for (std::size_t j = 0; j < idx.size(); ++j) {
+            const float d = l2 ? q_term[qi] + sq[j] + 2.0f * dist[j] : dist[j];
+            push_topk(heap, k, idx[j], d);
+          }
+        }
+      }
+
+      // The expansion loses precision when ||q|| and ||x|| dwarf their
+      // difference; report exact distances for the winners instead.
+      for (std::size_t qi = q0; qi < q1; ++qi) {
+        auto res = drain_sorted(heaps[qi - q0]);
+        const float* q = queries[qi].data();
+        const float q_inv = uses_norms_ ? q_term[qi] : 1.0f;
+        for (auto& r : res) {
+          const float x_inv = uses_norms_ ? store_.inv_norm(r.index) : 1.0f;
+          r.distance = exact(q, store_.row_f32(r.index, scratch.data()), dim, q_inv, x_inv);
+        }
+        std::sort(res.begin(), res.end(),
+                  [](const SearchResult& a, const SearchResult& b) {
+                    return a.distance < b.distance;
+                  });
+        out[qi] = std::move(res);
+      }
+    }
+  };
+
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, num_tiles);
+  if (threads <= 1) {
+    worker();
+    return out;
+  }
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (std::size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+  worker();
+  for (auto& th : pool) th.join();
+  return out;
 }
 
 }  // namespace vecdb
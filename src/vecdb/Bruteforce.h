@@ -5,6 +5,7 @@
 
 #include "Distance.h"
 #include "VectorStore.h"
+#include "VectorView.h"
 #include "SearchResult.h"
 namespace vecdb {
 
@@ -14,15 +15,62 @@ namespace vecdb {
 class Bruteforce {
  public:
   Bruteforce(const VectorStore& store, Metric metric)
-      : store_(store), metric_(metric) {}
+      : store_(store),
+        metric_(metric),
+        batch_dist_(Distance::resolve_batch(metric, store.row_stride())),
+        bounded_dist_(Distance::resolve_bounded(metric)),
+        half_dist_(Distance::resolve_half(metric, store.row_format())),
+        uses_norms_(metric == Metric::COSINE) {}
 
   // Returns up to k nearest alive vectors to query.
   // If k > number of alive vectors, returns fewer.
-  std::vector<SearchResult> search(const std::vector<float>& query, std::size_t k) const;
+  std::vector<SearchResult> search(VectorView query, std::size_t k) const;
+
+  // Exact topK for many queries at once (e.g. evaluation ground truth).
+  // Queries x rows are processed in tiles so each block of rows is loaded once
+  // per tile of queries; L2 uses ||q||^2 + ||x||^2 - 2 q.x so the inner loop is
+  // a dot product. The returned distances are recomputed exactly, so they match
+  // search(). threads == 0 uses std::thread::hardware_concurrency().
+  std::vector<std::vector<SearchResult>> search_batch(const std::vector<std::vector<float>>& queries,
+                                                      std::size_t k,
+                                                      std::size_t threads = 0) const;
+
+  // Approximate topK over the store's PQ codes (VectorStore::enable_pq()):
+  // every alive code is scored with the query's ADC table, reading m bytes per
+  // row instead of 4*dim. With rerank > 0 the best max(k, rerank) codes are
+  // rescored exactly on the float rows; with rerank == 0 the returned
+  // distances are the ADC estimates. Throws std::logic_error without codes.
+  std::vector<SearchResult> search_pq(VectorView query,
+                                      std::size_t k,
+                                      std::size_t rerank = 0) const;
+
+  // Two-pass search over the store's sign-bit codes
+  // (VectorStore::enable_binary()): every alive code is compared to the
+  // query's code by Hamming distance, reading dim/8 bytes per row, and the
+  // max(k, shortlist) closest are rescored exactly with the engine's metric.
+  // Meant for COSINE (signs track angles); returned distances are exact.
+  // Throws std::logic_error without codes.
+  std::vector<SearchResult> search_binary(VectorView query,
+                                          std::size_t k,
+                                          std::size_t shortlist) const;
+
+  Metric metric() const { return metric_; }
 
  private:
   const VectorStore& store_;
   Metric metric_;
+
+  // Metric and dim-specialized kernels resolved once at construction. The
+  // float kernels take row_stride() as their length and a query laid out by
+  // VectorStore::aligned_query().
+  BatchDistanceFn batch_dist_;
+  BoundedBatchDistanceFn bounded_dist_;  // nullptr unless the metric can abandon early
+  HalfDistanceFn half_dist_;  // set iff the store keeps F16 / BF16 rows; replaces the above
+  bool uses_norms_;
+
+  // Rescores results exactly on the float rows and re-sorts them. query must
+  // be in the row layout (VectorStore::aligned_query()).
+  void rerank_exact(const float* query, float q_inv, std::vector<SearchResult>& results) const;
 };
 
 }  // namespace vecdb
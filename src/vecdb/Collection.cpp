@@ -6,6 +6,7 @@
 #include <shared_mutex>
 #include <stdexcept>
 
+#include "Bruteforce.h"
 #include "Serializer.h"
 
 namespace vecdb {
@@ -31,9 +32,17 @@ static bool file_exists(const fs::path& p) {
 Collection::Collection(std::string dir, Options opt)
     : dir_(std::move(dir)),
       opt_(opt),
-      store_(opt_.dim),
+      store_(opt_.dim, opt_.row_format, opt_.pad_rows),
       hnsw_(nullptr) {
   if (opt_.dim == 0) throw std::invalid_argument("Collection: dim must be > 0");
+  if (opt_.pq_m > 0 && opt_.dim % opt_.pq_m != 0) {
+    throw std::invalid_argument("Collection: pq_m must divide dim");
+  }
+  if (opt_.normalize && opt_.metric != Metric::COSINE) {
+    throw std::invalid_argument("Collection: normalize requires the COSINE metric");
+  }
+  store_.set_unit_norm(opt_.normalize);
+  if (opt_.binary_shortlist > 0) store_.enable_binary();
 }
 
 Collection::Collection(Collection&& other) noexcept
@@ -68,6 +77,12 @@ Collection Collection::open(const std::string& dir) {
   opt.dim = mf.dim;
   opt.metric = mf.metric;
   opt.hnsw_params = mf.hnsw_params;
+  opt.normalize = mf.normalize;
+  opt.sq8 = mf.sq8;
+  opt.pq_m = mf.pq_m;
+  opt.binary_shortlist = mf.binary_shortlist;
+  opt.row_format = mf.row_format;
+  opt.pad_rows = mf.pad_rows;
 
   Collection c(dir, opt);
   c.load();
@@ -84,6 +99,36 @@ Metric Collection::metric() const {
   return opt_.metric;
 }
 
+bool Collection::normalized() const {
+  std::shared_lock lock(mtx_);
+  return opt_.normalize;
+}
+
+bool Collection::quantized() const {
+  std::shared_lock lock(mtx_);
+  return opt_.sq8;
+}
+
+std::size_t Collection::pq_subspaces() const {
+  std::shared_lock lock(mtx_);
+  return opt_.pq_m;
+}
+
+RowFormat Collection::row_format() const {
+  std::shared_lock lock(mtx_);
+  return opt_.row_format;
+}
+
+bool Collection::padded_rows() const {
+  std::shared_lock lock(mtx_);
+  return opt_.pad_rows;
+}
+
+std::size_t Collection::binary_shortlist() const {
+  std::shared_lock lock(mtx_);
+  return opt_.binary_shortlist;
+}
+
 const std::string& Collection::dir() const {
   std::shared_lock lock(mtx_);
   return dir_;
@@ -96,14 +141,10 @@ std::size_t Collection::size() const {
 
 std::size_t Collection::alive_count() const {
   std::shared_lock lock(mtx_);
-  std::size_t cnt = 0;
-  for (std::size_t i = 0; i < store_.size(); ++i) {
-    if (store_.is_alive(i)) ++cnt;
-  }
-  return cnt;
+  return store_.alive_count();
 }
 
-const std::string& Collection::id_at(std::size_t index) const {
+std::string_view Collection::id_at(std::size_t index) const {
   std::shared_lock lock(mtx_);
   return store_.id_at(index);
 }
@@ -120,38 +161,93 @@ const Metadata* Collection::metadata_of(const std::string& id) const {
 
 void Collection::set_metric(Metric m) {
   std::unique_lock lock(mtx_);
+  if (opt_.normalize && m != Metric::COSINE) {
+    throw std::invalid_argument("Collection::set_metric: normalize requires the COSINE metric");
+  }
   opt_.metric = m;
   if (hnsw_) hnsw_.reset();
 }
 
+Hnsw::Params Collection::hnsw_params() const {
+  std::shared_lock lock(mtx_);
+  return opt_.hnsw_params;
+}
+
 void Collection::set_hnsw_params(Hnsw::Params p) {
   std::unique_lock lock(mtx_);
   opt_.hnsw_params = p;
   if (hnsw_) hnsw_.reset();
 }
 
-std::size_t Collection::upsert(const std::string& id, const std::vector<float>& vec) {
+std::size_t Collection::upsert(const std::string& id, VectorView vec) {
   return upsert(id, vec, Metadata{});
 }
 
 std::size_t Collection::upsert(const std::string& id,
-                               const std::vector<float>& vec,
-                               const Metadata& meta) {
+                               VectorView vec,
+                               Metadata meta) {
   std::unique_lock lock(mtx_);
   if (vec.size() != opt_.dim) throw std::invalid_argument("Collection::upsert: vector dim mismatch");
 
-  std::size_t idx = store_.upsert(id, vec, meta);
+  std::size_t idx;
+  if (opt_.normalize) {
+    std::vector<float> unit(vec.begin(), vec.end());
+    Distance::normalize_inplace(unit.data(), unit.size());
+    idx = store_.upsert(id, unit, std::move(meta));
+  } else {
+    idx = store_.upsert(id, vec, std::move(meta));
+  }
 
-  // v1 correctness-first: any mutation invalidates index (rebuild later).
-  if (hnsw_) hnsw_.reset();
+  // Keep a built index live: new slots are linked in, changed or revived
+  // ones re-linked (Hnsw::update()).
+  if (hnsw_) hnsw_->update(idx);
   return idx;
 }
 
+void Collection::upsert_batch(const std::vector<std::string>& ids,
+                              VectorView vectors,
+                              std::vector<Metadata> meta) {
+  std::unique_lock lock(mtx_);
+  if (vectors.size() != ids.size() * opt_.dim) {
+    throw std::invalid_argument("Collection::upsert_batch: vector dim mismatch");
+  }
+  const std::size_t old_size = store_.size();
+
+  if (opt_.normalize) {
+    std::vector<float> unit(vectors.begin(), vectors.end());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      Distance::normalize_inplace(unit.data() + i * opt_.dim, opt_.dim);
+    }
+    store_.upsert_batch(ids, unit, std::move(meta));
+  } else {
+    store_.upsert_batch(ids, vectors, std::move(meta));
+  }
+
+  if (!hnsw_) return;
+  // Existing slots are re-linked one by one; the appended ones go through
+  // insert_batch() so a parallel build_threads setting applies to them too.
+  std::vector<std::size_t> existing;
+  std::vector<std::size_t> appended;
+  for (std::size_t i = old_size; i < store_.size(); ++i) appended.push_back(i);
+  for (const auto& id : ids) {
+    std::size_t idx = 0;
+    if (store_.try_get_index(id, idx) && idx < old_size) existing.push_back(idx);
+  }
+  std::sort(existing.begin(), existing.end());
+  existing.erase(std::unique(existing.begin(), existing.end()), existing.end());
+  for (std::size_t idx : existing) hnsw_->update(idx);
+  hnsw_->insert_batch(appended);
+}
+
 bool Collection::remove(const std::string& id) {
   std::unique_lock lock(mtx_);
-  bool ok = store_.remove(id);
-  if (ok && hnsw_) hnsw_.reset();
-  return ok;
+  std::size_t idx = 0;
+  if (!store_.try_get_index(id, idx)) return false;
+  store_.remove(id);
+  // The slot stays in the graph as a tombstone; its neighbors are
+  // reconnected around it now (Hnsw::remove()).
+  if (hnsw_) hnsw_->remove(idx);
+  return true;
 }
 
 bool Collection::contains(const std::string& id) const {
@@ -164,12 +260,31 @@ bool Collection::has_index() const {
   return hnsw_ != nullptr;
 }
 
+void Collection::drop_index() {
+  std::unique_lock lock(mtx_);
+  hnsw_.reset();
+}
+
+std::size_t Collection::repair_index() {
+  std::unique_lock lock(mtx_);
+  return hnsw_ ? hnsw_->repair_tombstones() : 0;
+}
+
 void Collection::build_index() {
   std::unique_lock lock(mtx_);
+  if (opt_.sq8) store_.enable_sq8();
+  if (opt_.pq_m > 0) store_.enable_pq(opt_.pq_m);
   hnsw_ = std::make_unique<Hnsw>(store_, opt_.metric, opt_.hnsw_params);
-  for (std::size_t i = 0; i < store_.size(); ++i) {
-    if (store_.is_alive(i)) hnsw_->insert(i);
-  }
+  std::vector<std::size_t> slots;
+  slots.reserve(store_.alive_count());
+  store_.alive().for_each([&](std::size_t i) { slots.push_back(i); });
+  hnsw_->insert_batch(slots);
+}
+
+static std::vector<float> normalized_copy(VectorView v) {
+  std::vector<float> out(v.begin(), v.end());
+  Distance::normalize_inplace(out.data(), out.size());
+  return out;
 }
 
 void Collection::ensure_index_ready() const {
@@ -179,12 +294,24 @@ void Collection::ensure_index_ready() const {
   }
 }
 
-std::vector<SearchResult> Collection::search(const std::vector<float>& query,
+std::vector<SearchResult> Collection::search(VectorView query,
                                              std::size_t k,
                                              std::size_t ef_search) const {
   std::shared_lock lock(mtx_);
   if (query.size() != opt_.dim) throw std::invalid_argument("Collection::search: query dim mismatch");
+  if (!opt_.normalize) return index_search(query, k, ef_search);
+  return index_search(normalized_copy(query), k, ef_search);
+}
+
+std::vector<SearchResult> Collection::index_search(VectorView query,
+                                                   std::size_t k,
+                                                   std::size_t ef_search) const {
+  if (opt_.binary_shortlist > 0) {
+    return Bruteforce(store_, opt_.metric).search_binary(query, k, opt_.binary_shortlist);
+  }
   ensure_index_ready();
+  if (opt_.pq_m > 0) return hnsw_->search_pq(query, k, ef_search);
+  if (opt_.sq8) return hnsw_->search_quantized(query, k, ef_search);
   return hnsw_->search(query, k, ef_search);
 }
 
@@ -194,30 +321,42 @@ static bool metadata_matches(const Metadata& meta, const Collection::MetadataFil
   return it != meta.end() && it->second == filter.value;
 }
 
-std::vector<SearchResult> Collection::search(const std::vector<float>& query,
+std::vector<SearchResult> Collection::search(VectorView query,
                                              std::size_t k,
                                              std::size_t ef_search,
                                              const MetadataFilter& filter) const {
   std::shared_lock lock(mtx_);
   if (query.size() != opt_.dim) throw std::invalid_argument("Collection::search: query dim mismatch");
 
-  if (filter.empty()) {
-    ensure_index_ready();
-    return hnsw_->search(query, k, ef_search);
-  }
+  std::vector<float> unit_query;
+  if (opt_.normalize) unit_query = normalized_copy(query);
+  const VectorView q = opt_.normalize ? VectorView(unit_query) : query;
+
+  if (filter.empty()) return index_search(q, k, ef_search);
 
   // Filtered search (exact scan for correctness). Can be optimized later.
   std::vector<SearchResult> heap;
   heap.reserve(k + 1);
 
-  for (std::size_t i = 0; i < store_.size(); ++i) {
-    if (!store_.is_alive(i)) continue;
-    if (!metadata_matches(store_.metadata_at(i), filter)) continue;
+  // Metric (and dim-specialized kernel) resolved once for the whole scan.
+  // Padded rows are scored over the full stride with the aligned kernels.
+  const std::size_t stride = store_.row_stride();
+  const DistanceFn dist = opt_.pad_rows ? Distance::resolve_aligned(opt_.metric, stride)
+                                        : Distance::resolve(opt_.metric, opt_.dim);
+  AlignedVector<float> q_buf;
+  const float* q_row = store_.aligned_query(q.data(), q_buf);
+  const HalfDistanceFn half_dist = Distance::resolve_half(opt_.metric, opt_.row_format);
+  const bool uses_norms = (opt_.metric == Metric::COSINE);
 
-    const float* p = store_.get_ptr(i);
-    if (!p) continue;
+  // Normalized collections already hold a unit query: COSINE is 1 - dot.
+  const float q_inv = (uses_norms && !opt_.normalize) ? Distance::inv_norm(q.data(), opt_.dim) : 1.0f;
 
-    float d = Distance::distance(opt_.metric, query.data(), p, opt_.dim);
+  store_.alive().for_each([&](std::size_t i) {
+    if (!metadata_matches(store_.metadata_at(i), filter)) return;
+
+    const float x_inv = uses_norms ? store_.inv_norm(i) : 1.0f;
+    float d = half_dist ? half_dist(q.data(), store_.half_row_ptr(i), opt_.dim, q_inv, x_inv)
+                        : dist(q_row, store_.row_ptr(i), stride, q_inv, x_inv);
 
     if (heap.size() < k) {
       heap.push_back({i, d});
@@ -232,7 +371,7 @@ std::vector<SearchResult> Collection::search(const std::vector<float>& query,
       std::push_heap(heap.begin(), heap.end(),
                      [](const auto& a, const auto& b) { return a.distance < b.distance; });
     }
-  }
+  });
 
   if (heap.empty()) return heap;
   std::sort(heap.begin(), heap.end(),
@@ -249,6 +388,12 @@ void Collection::save() const {
   mf.dim = opt_.dim;
   mf.metric = opt_.metric;
   mf.hnsw_params = opt_.hnsw_params;
+  mf.normalize = opt_.normalize;
+  mf.sq8 = opt_.sq8;
+  mf.pq_m = opt_.pq_m;
+  mf.binary_shortlist = opt_.binary_shortlist;
+  mf.row_format = opt_.row_format;
+  mf.pad_rows = opt_.pad_rows;
 
   Serializer::write_manifest(dir_, mf);
   Serializer::save_store(dir_, store_);
@@ -265,6 +410,12 @@ void Collection::save() const {
 void Collection::load() {
   std::unique_lock lock(mtx_);
   Serializer::load_store(dir_, store_);
+  if (opt_.sq8) store_.enable_sq8();
+  if (opt_.binary_shortlist > 0) store_.enable_binary();
+  // pq.bin is written on save(); only retrain if it is missing or stale.
+  if (opt_.pq_m > 0 && (!store_.has_pq() || store_.pq().m() != opt_.pq_m)) {
+    store_.enable_pq(opt_.pq_m);
+  }
 
   fs::path hnsw_path = fs::path(dir_) / "hnsw.bin";
   if (file_exists(hnsw_path)) {
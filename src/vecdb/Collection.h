@@ -4,12 +4,14 @@
 #include <memory>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Distance.h"
 #include "Metadata.h"
 #include "SearchResult.h"
 #include "VectorStore.h"
+#include "VectorView.h"
 #include "Hnsw.h"
 
 namespace vecdb {
@@ -20,6 +22,34 @@ class Collection {
     std::size_t dim = 0;
     Metric metric = Metric::L2;
     Hnsw::Params hnsw_params{};
+    // L2-normalize vectors on upsert and queries on search, so COSINE runs as
+    // 1 - dot with no norm work per distance. Only valid with COSINE; the
+    // constructor and set_metric() reject any other metric. Recorded in the
+    // manifest.
+    bool normalize = false;
+    // Keep SQ8 codes next to the rows and traverse HNSW on them, reranking
+    // the final candidates exactly (Hnsw::search_quantized). Codes are trained
+    // by build_index() and on open(); not persisted. Recorded in the manifest.
+    bool sq8 = false;
+    // When > 0, keep PQ codes with this many subspaces (must divide dim) and
+    // traverse HNSW on them (Hnsw::search_pq), reranking exactly. Codebooks
+    // are trained by build_index() and persisted in pq.bin. Takes precedence
+    // over sq8 for search. Recorded in the manifest.
+    std::size_t pq_m = 0;
+    // When > 0, keep 1-bit sign codes and answer unfiltered search() with a
+    // Hamming scan that reranks this many candidates exactly
+    // (Bruteforce::search_binary); no index is needed. Intended for COSINE.
+    // Codes are rebuilt on open(), not persisted. Recorded in the manifest.
+    std::size_t binary_shortlist = 0;
+    // Element type of the stored rows. F16 / BF16 halve RAM and vectors.bin;
+    // queries stay float and rows are widened inside the distance kernels.
+    // Recorded in the manifest.
+    RowFormat row_format = RowFormat::F32;
+    // Pad each F32 row in memory to a multiple of 16 floats on a cache-line
+    // boundary so distance kernels use aligned loads with no tail loop
+    // (VectorStore pad_rows). vectors.bin is unaffected. Recorded in the
+    // manifest.
+    bool pad_rows = false;
   };
 
   static Collection create(const std::string& dir, Options opt);
@@ -32,24 +62,43 @@ class Collection {
 
   std::size_t dim() const;
   Metric metric() const;
+  bool normalized() const;
+  bool quantized() const;
+  std::size_t pq_subspaces() const;
+  std::size_t binary_shortlist() const;
+  RowFormat row_format() const;
+  bool padded_rows() const;
   const std::string& dir() const;
 
   // slots (includes dead)
   std::size_t size() const;
 
-  // alive count (computed)
+  // alive count (maintained by the store, O(1))
   std::size_t alive_count() const;
 
-  // printing / debug helper
-  const std::string& id_at(std::size_t index) const;
+  // printing / debug helper (view valid until the next mutation)
+  std::string_view id_at(std::size_t index) const;
 
   // metadata helper
   const Metadata& metadata_at(std::size_t index) const;
   const Metadata* metadata_of(const std::string& id) const;
 
   // --- mutation ---
-  std::size_t upsert(const std::string& id, const std::vector<float>& vec);
-  std::size_t upsert(const std::string& id, const std::vector<float>& vec, const Metadata& meta);
+  // Writes keep a built index searchable: upserts link new slots into the
+  // HNSW graph and re-link changed ones, removes leave a tombstone that
+  // search skips and reconnect its neighbors around it. repair_index()
+  // unlinks tombstones for good; build_index() rebuilds from scratch.
+  // vec may point anywhere (see VectorView); it is copied into the store.
+  // meta is taken by value, so callers can std::move() it in.
+  std::size_t upsert(const std::string& id, VectorView vec);
+  std::size_t upsert(const std::string& id, VectorView vec, Metadata meta);
+
+  // Bulk upsert under one lock (see VectorStore::upsert_batch): vectors holds
+  // ids.size() rows back to back, meta is empty or one entry per id.
+  void upsert_batch(const std::vector<std::string>& ids,
+                    VectorView vectors,
+                    std::vector<Metadata> meta = {});
+
   bool remove(const std::string& id);
   bool contains(const std::string& id) const;
 
@@ -57,8 +106,21 @@ class Collection {
   void build_index();
   bool has_index() const;
 
+  // Discards the in-memory index (the next save() deletes hnsw.bin). Bulk
+  // loads that end in build_index() call it first, so the rows they add are
+  // not linked one by one into a graph that is about to be replaced.
+  void drop_index();
+
+  // Batch tombstone repair (Hnsw::repair_tombstones()) under the write lock;
+  // returns the number of neighbor lists rewritten (0 without an index).
+  // Worth running after heavy deletes, e.g. from a maintenance thread.
+  std::size_t repair_index();
+
   // Allow CLI to override index parameters before build_index()
+  // set_metric() throws std::invalid_argument for a non-COSINE metric on a
+  // normalized collection.
   void set_metric(Metric m);
+  Hnsw::Params hnsw_params() const;
   void set_hnsw_params(Hnsw::Params p);
 
   struct MetadataFilter {
@@ -67,11 +129,11 @@ class Collection {
     bool empty() const { return key.empty(); }
   };
 
-  std::vector<SearchResult> search(const std::vector<float>& query,
+  std::vector<SearchResult> search(VectorView query,
                                   std::size_t k,
                                   std::size_t ef_search) const;
 
-  std::vector<SearchResult> search(const std::vector<float>& query,
+  std::vector<SearchResult> search(VectorView query,
                                    std::size_t k,
                                    std::size_t ef_search,
                                    const MetadataFilter& filter) const;
@@ -83,6 +145,9 @@ class Collection {
  private:
   Collection(std::string dir, Options opt);
   void ensure_index_ready() const;
+  std::vector<SearchResult> index_search(VectorView query,
+                                         std::size_t k,
+                                         std::size_t ef_search) const;
 
   std::string dir_;
   Options opt_;
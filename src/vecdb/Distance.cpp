@@ -3,29 +3,128 @@
 #include <cmath>
 #include <algorithm>
 
+#include "DistanceSimd.h"
+
 namespace vecdb {
 
+// Kernels are picked once from CPUID (see DistanceSimd.cpp); every call below
+// goes straight to the fastest implementation the CPU supports.
+
 float Distance::l2_sq(const float* a, const float* b, std::size_t dim) {
-  float sum = 0.0f;
-  for (std::size_t i = 0; i < dim; ++i) {
-    float d = a[i] - b[i];
-    sum += d * d;
-  }
-  return sum;
+  return simd::active().l2_sq(a, b, dim);
+}
+
+float Distance::l2_sq_bounded(const float* a, const float* b, std::size_t dim, float bound) {
+  return simd::active().l2_sq_bounded(a, b, dim, bound);
 }
 
 float Distance::dot(const float* a, const float* b, std::size_t dim) {
-  float sum = 0.0f;
-  for (std::size_t i = 0; i < dim; ++i) {
-    sum += a[i] * b[i];
+  return simd::active().dot(a, b, dim);
+}
+
+DistanceFn Distance::resolve(Metric metric, std::size_t dim) {
+  const auto& k = simd::active();
+  if (const simd::FixedKernels* f = k.find_fixed(dim)) {
+    switch (metric) {
+      case Metric::L2:
+        return f->l2_dist;
+      case Metric::COSINE:
+        return f->cosine_dist;
+      case Metric::IP:
+        return f->ip_dist;
+      default:
+        return f->l2_dist;
+    }
+  }
+  switch (metric) {
+    case Metric::L2:
+      return k.l2_dist;
+    case Metric::COSINE:
+      return k.cosine_dist;
+    case Metric::IP:
+      return k.ip_dist;
+    default:
+      return k.l2_dist;
   }
-  return sum;
+}
+
+BatchDistanceFn Distance::resolve_batch(Metric metric, std::size_t dim) {
+  const auto& k = simd::active();
+  if (const simd::FixedKernels* f = k.find_fixed(dim)) {
+    switch (metric) {
+      case Metric::L2:
+        return f->l2_batch;
+      case Metric::COSINE:
+        return f->cosine_batch;
+      case Metric::IP:
+        return f->ip_batch;
+      default:
+        return f->l2_batch;
+    }
+  }
+  switch (metric) {
+    case Metric::L2:
+      return k.l2_batch;
+    case Metric::COSINE:
+      return k.cosine_batch;
+    case Metric::IP:
+      return k.ip_batch;
+    default:
+      return k.l2_batch;
+  }
+}
+
+BoundedBatchDistanceFn Distance::resolve_bounded(Metric metric) {
+  return metric == Metric::L2 ? simd::active().l2_batch_bounded : nullptr;
+}
+
+DistanceFn Distance::resolve_aligned(Metric metric, std::size_t dim) {
+  const auto& k = simd::active();
+  if (dim % kRowPad != 0 || k.find_fixed(dim)) return resolve(metric, dim);
+  switch (metric) {
+    case Metric::L2:
+      return k.aligned.l2_dist;
+    case Metric::COSINE:
+      return k.aligned.cosine_dist;
+    case Metric::IP:
+      return k.aligned.ip_dist;
+    default:
+      return k.aligned.l2_dist;
+  }
+}
+
+HalfDistanceFn Distance::resolve_half(Metric metric, RowFormat format) {
+  const auto& k = simd::active();
+  const simd::HalfKernels* h = nullptr;
+  if (format == RowFormat::F16) h = &k.f16;
+  if (format == RowFormat::BF16) h = &k.bf16;
+  if (!h) return nullptr;
+  switch (metric) {
+    case Metric::L2:
+      return h->l2_dist;
+    case Metric::COSINE:
+      return h->cosine_dist;
+    case Metric::IP:
+      return h->ip_dist;
+    default:
+      return h->l2_dist;
+  }
+}
+
+const char* Distance::simd_name() {
+  return simd::active().name;
 }
 
 float Distance::norm(const float* a, std::size_t dim) {
   return std::sqrt(dot(a, a, dim));
 }
 
+float Distance::inv_norm(const float* a, std::size_t dim) {
+  float n = norm(a, dim);
+  if (n < 1e-12f) return 0.0f;
+  return 1.0f / n;
+}
+
 void Distance::normalize_inplace(float* v, std::size_t dim) {
   float n = norm(v, dim);
   // avoid divide-by-zero; also avoid blowing up for extremely tiny norm
@@ -47,16 +146,41 @@ float Distance::cosine_distance(const float* a, const float* b, std::size_t dim)
   return 1.0f - cosine_similarity(a, b, dim);
 }
 
+float Distance::ip_distance(const float* a, const float* b, std::size_t dim) {
+  return -dot(a, b, dim);
+}
+
+float Distance::cosine_distance(const float* a, const float* b, std::size_t dim,
+                                float inv_a, float inv_b) {
+  return 1.0f - dot(a, b, dim) * inv_a * inv_b;
+}
+
 float Distance::distance(Metric metric, const float* a, const float* b, std::size_t dim) {
   switch (metric) {
     case Metric::L2:
       return l2_sq(a, b, dim);
     case Metric::COSINE:
       return cosine_distance(a, b, dim);
+    case Metric::IP:
+      return ip_distance(a, b, dim);
     default:
       // fallback
       return l2_sq(a, b, dim);
   }
 }
 
+float Distance::distance(Metric metric, const float* a, const float* b, std::size_t dim,
+                         float inv_a, float inv_b) {
+  switch (metric) {
+    case Metric::L2:
+      return l2_sq(a, b, dim);
+    case Metric::COSINE:
+      return cosine_distance(a, b, dim, inv_a, inv_b);
+    case Metric::IP:
+      return ip_distance(a, b, dim);
+    default:
+      return l2_sq(a, b, dim);
+  }
+}
+
 } // namespace vecdb
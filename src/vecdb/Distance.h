@@ -1,25 +1,65 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include "AlignedAllocator.h"
+#include "Half.h"
+
 namespace vecdb {
 
 enum class Metric {
   L2,      // squared L2 distance
-  COSINE   // cosine distance = 1 - cosine_similarity
+  COSINE,  // cosine distance = 1 - cosine_similarity
+  IP       // inner product (MIPS): distance = -dot(a, b)
 };
 
+// Distance between two rows given their inverse L2 norms (only COSINE reads
+// them). Obtained from Distance::resolve() once per engine so hot loops call
+// straight into the metric's kernel without switching on Metric.
+using DistanceFn = float (*)(const float* a, const float* b, std::size_t dim,
+                             float inv_a, float inv_b);
+
+// One query against n rows: out[i] = DistanceFn(query, rows[i], dim, inv_query,
+// inv_rows[i]). inv_rows may be nullptr, meaning every row has norm 1 (or the
+// metric ignores norms). Rows are processed several at a time so each query
+// load is shared across rows.
+using BatchDistanceFn = void (*)(const float* query, const float* const* rows, std::size_t n,
+                                 std::size_t dim, float inv_query, const float* inv_rows,
+                                 float* out);
+
+// Early-abandon batch: out[i] is the exact distance when it is <= bound,
+// otherwise any value > bound (the partial sum at the point the kernel gave
+// up on that row). Callers keeping a bounded top-k pass their current worst.
+using BoundedBatchDistanceFn = void (*)(const float* query, const float* const* rows,
+                                        std::size_t n, std::size_t dim, float bound,
+                                        float* out);
+
+// Float query against a row stored as F16 or BF16 (see RowFormat). The row
+// is widened to float in-register, so only 2*dim bytes are read from memory.
+using HalfDistanceFn = float (*)(const float* query, const std::uint16_t* row, std::size_t dim,
+                                 float inv_query, float inv_row);
+
+// l2_sq / dot run on SIMD kernels chosen once at startup from CPUID
+// (AVX-512 > AVX2+FMA > SSE2 > scalar).
 struct Distance {
   // squared L2 distance (no sqrt)
   static float l2_sq(const float* a, const float* b, std::size_t dim);
 
+  // squared L2 distance that stops once the running sum exceeds bound: exact
+  // if the result is <= bound, otherwise only known to be > bound.
+  static float l2_sq_bounded(const float* a, const float* b, std::size_t dim, float bound);
+
   // dot product
   static float dot(const float* a, const float* b, std::size_t dim);
 
   // L2 norm (sqrt of sum of squares)
   static float norm(const float* a, std::size_t dim);
 
+  // 1 / ||a||, or 0 if the norm is ~0 (so cosine against it degrades to "orthogonal").
+  static float inv_norm(const float* a, std::size_t dim);
+
   // in-place normalize vector to unit length (if norm is ~0, leave unchanged)
   static void normalize_inplace(float* v, std::size_t dim);
 
@@ -29,8 +69,48 @@ struct Distance {
   // cosine distance: 1 - cosine_similarity
   static float cosine_distance(const float* a, const float* b, std::size_t dim);
 
+  // negative inner product: lower is closer, so maximum dot ranks first.
+  static float ip_distance(const float* a, const float* b, std::size_t dim);
+
+  // cosine distance with precomputed inverse norms: one dot product, no norm passes.
+  static float cosine_distance(const float* a, const float* b, std::size_t dim,
+                               float inv_a, float inv_b);
+
   // Unified distance API (lower is closer)
   static float distance(Metric metric, const float* a, const float* b, std::size_t dim);
+
+  // Same as above, but COSINE uses the given inverse norms (see inv_norm()).
+  // L2 and IP ignore them.
+  static float distance(Metric metric, const float* a, const float* b, std::size_t dim,
+                        float inv_a, float inv_b);
+
+  // Resolve the metric to a function for the kernel set selected at startup.
+  // Calling the result is equivalent to distance(metric, a, b, dim, inv_a, inv_b).
+  // If dim is a common embedding size (128, 384, 768, 1024, 1536) the result is
+  // compiled for exactly that dim and must only be called with it; otherwise
+  // (or for dim == 0) the generic runtime-length kernel is returned.
+  static DistanceFn resolve(Metric metric, std::size_t dim = 0);
+
+  // Batched counterpart of resolve(), with the same dim specialization rules.
+  static BatchDistanceFn resolve_batch(Metric metric, std::size_t dim = 0);
+
+  // Early-abandon batch kernel for the metric, or nullptr if it has none. Only
+  // L2 qualifies: its partial sums never decrease, so a partial sum above the
+  // bound already rules the row out.
+  static BoundedBatchDistanceFn resolve_bounded(Metric metric);
+
+  // Kernel for rows of a padded VectorStore (see VectorStore::padded_rows()):
+  // dim must be a multiple of kRowPad and every pointer passed to the result
+  // kCacheLine-aligned. Specialized dims keep their fixed kernel (already
+  // tail-free); other dims get aligned-load kernels with no remainder loop.
+  // Falls back to resolve(metric, dim) if dim is not a multiple of kRowPad.
+  static DistanceFn resolve_aligned(Metric metric, std::size_t dim);
+
+  // Metric kernel for rows stored in a half format, or nullptr for F32.
+  static HalfDistanceFn resolve_half(Metric metric, RowFormat format);
+
+  // Name of the kernel set selected at startup ("scalar", "sse2", "avx2", "avx512").
+  static const char* simd_name();
 };
 
 } // namespace vecdb
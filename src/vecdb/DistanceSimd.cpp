@@ -0,0 +1,1229 @@
+#include "DistanceSimd.h"
+
+#include <algorithm>
+
+#include "Half.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VECDB_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang need per-function target attributes so the rest of the build can
+// stay at the baseline ISA. MSVC exposes all intrinsics unconditionally.
+#if defined(VECDB_X86) && (defined(__GNUC__) || defined(__clang__))
+#define VECDB_TARGET_SSE2 __attribute__((target("sse2")))
+#define VECDB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define VECDB_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#define VECDB_TARGET_AVX512 __attribute__((target("avx512f,fma")))
+#define VECDB_TARGET_POPCNT __attribute__((target("popcnt")))
+#else
+#define VECDB_TARGET_SSE2
+#define VECDB_TARGET_AVX2
+#define VECDB_TARGET_AVX2_F16C
+#define VECDB_TARGET_AVX512
+#define VECDB_TARGET_POPCNT
+#endif
+
+#if defined(_MSC_VER)
+#define VECDB_INLINE __forceinline
+#else
+#define VECDB_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace vecdb::simd {
+
+namespace {
+
+// Each ISA section defines force-inlined kernel bodies (*_impl). The
+// VECDB_DEFINE_ENTRY_POINTS macro then stamps out the out-of-line functions
+// stored in the dispatch table: the raw kernels plus one DistanceFn per
+// metric, so the metric arithmetic is folded into the kernel's own loop.
+#define VECDB_DEFINE_ENTRY_POINTS(isa, TARGET)                                     \
+  VECDB_DEFINE_BATCH_IMPL(isa, TARGET)                                             \
+  TARGET float l2_sq_##isa(const float* a, const float* b, std::size_t dim) {     \
+    return l2_sq_##isa##_impl(a, b, dim);                                          \
+  }                                                                                \
+  TARGET float dot_##isa(const float* a, const float* b, std::size_t dim) {       \
+    return dot_##isa##_impl(a, b, dim);                                            \
+  }                                                                                \
+  TARGET float l2_sq_bounded_##isa(const float* a, const float* b,               \
+                                   std::size_t dim, float bound) {                 \
+    return l2_sq_bounded_##isa##_impl(a, b, dim, bound);                           \
+  }                                                                                \
+  TARGET void l2_batch_bounded_##isa(const float* q, const float* const* rows,    \
+                                     std::size_t n, std::size_t dim, float bound,  \
+                                     float* out) {                                 \
+    l2_batch_bounded_##isa##_impl(q, rows, n, dim, bound, out);                    \
+  }                                                                                \
+  TARGET float l2_dist_##isa(const float* a, const float* b, std::size_t dim,     \
+                             float, float) {                                       \
+    return l2_sq_##isa##_impl(a, b, dim);                                          \
+  }                                                                                \
+  TARGET float cosine_dist_##isa(const float* a, const float* b, std::size_t dim, \
+                                 float inv_a, float inv_b) {                       \
+    return 1.0f - dot_##isa##_impl(a, b, dim) * inv_a * inv_b;                     \
+  }                                                                                \
+  TARGET float ip_dist_##isa(const float* a, const float* b, std::size_t dim,     \
+                             float, float) {                                       \
+    return -dot_##isa##_impl(a, b, dim);                                           \
+  }                                                                                \
+  TARGET void l2_batch_##isa(const float* q, const float* const* rows,            \
+                             std::size_t n, std::size_t dim, float, const float*,  \
+                             float* out) {                                         \
+    l2_batch_##isa##_impl(q, rows, n, dim, out);                                   \
+  }                                                                                \
+  TARGET void cosine_batch_##isa(const float* q, const float* const* rows,        \
+                                 std::size_t n, std::size_t dim, float inv_q,      \
+                                 const float* inv_rows, float* out) {              \
+    cosine_batch_##isa##_impl(q, rows, n, dim, inv_q, inv_rows, out);              \
+  }                                                                                \
+  TARGET void ip_batch_##isa(const float* q, const float* const* rows,            \
+                             std::size_t n, std::size_t dim, float, const float*,  \
+                             float* out) {                                         \
+    ip_batch_##isa##_impl(q, rows, n, dim, out);                                   \
+  }                                                                                \
+  VECDB_DEFINE_FIXED_ENTRY_POINTS(isa, TARGET)
+
+// Batch bodies: rows are consumed four at a time through the *_x4 kernels,
+// which stream the query once for all four rows; leftovers go one by one.
+// The bounded variants walk dim in kAbandonBlock chunks and stop a row (or a
+// group of four, once every row in it is out) as soon as it passes the bound.
+#define VECDB_DEFINE_BATCH_IMPL(isa, TARGET)                                       \
+  TARGET VECDB_INLINE float l2_sq_bounded_##isa##_impl(const float* a,            \
+                                                       const float* b,             \
+                                                       std::size_t dim,            \
+                                                       float bound) {              \
+    float sum = 0.0f;                                                              \
+    std::size_t off = 0;                                                           \
+    for (; off + kAbandonBlock < dim; off += kAbandonBlock) {                      \
+      sum += l2_sq_##isa##_impl(a + off, b + off, kAbandonBlock);                  \
+      if (sum > bound) return sum;                                                 \
+    }                                                                              \
+    return sum + l2_sq_##isa##_impl(a + off, b + off, dim - off);                  \
+  }                                                                                \
+  TARGET VECDB_INLINE void l2_batch_bounded_##isa##_impl(                         \
+      const float* q, const float* const* rows, std::size_t n, std::size_t dim,    \
+      float bound, float* out) {                                                   \
+    std::size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) {                                                   \
+      float* o = out + i;                                                          \
+      o[0] = o[1] = o[2] = o[3] = 0.0f;                                            \
+      for (std::size_t off = 0; off < dim; off += kAbandonBlock) {                 \
+        const std::size_t len = std::min(kAbandonBlock, dim - off);                \
+        const float* r[4] = {rows[i] + off, rows[i + 1] + off, rows[i + 2] + off,  \
+                             rows[i + 3] + off};                                   \
+        float part[4];                                                             \
+        l2_sq_x4_##isa##_impl(q + off, r, len, part);                              \
+        for (int j = 0; j < 4; ++j) o[j] += part[j];                               \
+        if (o[0] > bound && o[1] > bound && o[2] > bound && o[3] > bound) break;   \
+      }                                                                            \
+    }                                                                              \
+    for (; i < n; ++i) {                                                           \
+      out[i] = l2_sq_bounded_##isa##_impl(q, rows[i], dim, bound);                 \
+    }                                                                              \
+  }                                                                                \
+  TARGET VECDB_INLINE void l2_batch_##isa##_impl(const float* q,                  \
+                                                 const float* const* rows,         \
+                                                 std::size_t n, std::size_t dim,   \
+                                                 float* out) {                     \
+    std::size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) l2_sq_x4_##isa##_impl(q, rows + i, dim, out + i);  \
+    for (; i < n; ++i) out[i] = l2_sq_##isa##_impl(q, rows[i], dim);               \
+  }                                                                                \
+  TARGET VECDB_INLINE void cosine_batch_##isa##_impl(                             \
+      const float* q, const float* const* rows, std::size_t n, std::size_t dim,   \
+      float inv_q, const float* inv_rows, float* out) {                            \
+    std::size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) dot_x4_##isa##_impl(q, rows + i, dim, out + i);    \
+    for (; i < n; ++i) out[i] = dot_##isa##_impl(q, rows[i], dim);                 \
+    for (i = 0; i < n; ++i) {                                                      \
+      out[i] = 1.0f - out[i] * inv_q * (inv_rows ? inv_rows[i] : 1.0f);            \
+    }                                                                              \
+  }                                                                                \
+  TARGET VECDB_INLINE void ip_batch_##isa##_impl(const float* q,                  \
+                                                 const float* const* rows,         \
+                                                 std::size_t n, std::size_t dim,   \
+                                                 float* out) {                     \
+    std::size_t i = 0;                                                             \
+    for (; i + 4 <= n; i += 4) dot_x4_##isa##_impl(q, rows + i, dim, out + i);    \
+    for (; i < n; ++i) out[i] = dot_##isa##_impl(q, rows[i], dim);                 \
+    for (i = 0; i < n; ++i) out[i] = -out[i];                                      \
+  }
+
+// Levels without a dedicated 4-row kernel run four independent kernels.
+#define VECDB_DEFINE_X4_FALLBACK(isa, TARGET)                                      \
+  TARGET VECDB_INLINE void l2_sq_x4_##isa##_impl(const float* q,                  \
+                                                 const float* const* r,            \
+                                                 std::size_t dim, float* out) {    \
+    for (int j = 0; j < 4; ++j) out[j] = l2_sq_##isa##_impl(q, r[j], dim);         \
+  }                                                                                \
+  TARGET VECDB_INLINE void dot_x4_##isa##_impl(const float* q,                    \
+                                               const float* const* r,              \
+                                               std::size_t dim, float* out) {      \
+    for (int j = 0; j < 4; ++j) out[j] = dot_##isa##_impl(q, r[j], dim);           \
+  }
+
+// Same entry points with the dimension as a template argument. The kernel body
+// is inlined with a constant trip count, so remainder loops and bounds checks
+// fold away. The runtime dim argument is ignored.
+#define VECDB_DEFINE_FIXED_ENTRY_POINTS(isa, TARGET)                               \
+  template <std::size_t D>                                                         \
+  TARGET float l2_sq_##isa##_fixed(const float* a, const float* b, std::size_t) { \
+    return l2_sq_##isa##_impl(a, b, D);                                            \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET float dot_##isa##_fixed(const float* a, const float* b, std::size_t) {   \
+    return dot_##isa##_impl(a, b, D);                                              \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET float l2_dist_##isa##_fixed(const float* a, const float* b, std::size_t, \
+                                     float, float) {                               \
+    return l2_sq_##isa##_impl(a, b, D);                                            \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET float cosine_dist_##isa##_fixed(const float* a, const float* b,          \
+                                         std::size_t, float inv_a, float inv_b) {  \
+    return 1.0f - dot_##isa##_impl(a, b, D) * inv_a * inv_b;                       \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET void l2_batch_##isa##_fixed(const float* q, const float* const* rows,    \
+                                     std::size_t n, std::size_t, float,            \
+                                     const float*, float* out) {                   \
+    l2_batch_##isa##_impl(q, rows, n, D, out);                                     \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET void cosine_batch_##isa##_fixed(const float* q, const float* const* rows,\
+                                         std::size_t n, std::size_t, float inv_q,  \
+                                         const float* inv_rows, float* out) {      \
+    cosine_batch_##isa##_impl(q, rows, n, D, inv_q, inv_rows, out);                \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET float ip_dist_##isa##_fixed(const float* a, const float* b, std::size_t, \
+                                     float, float) {                               \
+    return -dot_##isa##_impl(a, b, D);                                             \
+  }                                                                                \
+  template <std::size_t D>                                                         \
+  TARGET void ip_batch_##isa##_fixed(const float* q, const float* const* rows,    \
+                                     std::size_t n, std::size_t, float,            \
+                                     const float*, float* out) {                   \
+    ip_batch_##isa##_impl(q, rows, n, D, out);                                     \
+  }                                                                                \
+  const FixedKernels kFixed_##isa[] = {                                            \
+      VECDB_FIXED_ROW(isa, 128), VECDB_FIXED_ROW(isa, 384),                        \
+      VECDB_FIXED_ROW(isa, 768), VECDB_FIXED_ROW(isa, 1024),                       \
+      VECDB_FIXED_ROW(isa, 1536)};
+
+// Must list exactly the values of kFixedDims (checked below).
+#define VECDB_FIXED_ROW(isa, D)                                                    \
+  {D, &l2_sq_##isa##_fixed<D>, &dot_##isa##_fixed<D>, &l2_dist_##isa##_fixed<D>,  \
+   &cosine_dist_##isa##_fixed<D>, &ip_dist_##isa##_fixed<D>,                      \
+   &l2_batch_##isa##_fixed<D>, &cosine_batch_##isa##_fixed<D>,                    \
+   &ip_batch_##isa##_fixed<D>}
+
+// Padded-row entry points (see AlignedKernels). Each ISA provides
+// l2_sq_aligned_<isa>_impl and dot_aligned_<isa>_impl, which may assume dim is
+// a multiple of kRowPad and both pointers are kCacheLine-aligned.
+#define VECDB_DEFINE_ALIGNED_ENTRY_POINTS(isa, TARGET)                             \
+  TARGET float l2_dist_aligned_##isa(const float* a, const float* b,              \
+                                     std::size_t dim, float, float) {              \
+    return l2_sq_aligned_##isa##_impl(a, b, dim);                                  \
+  }                                                                                \
+  TARGET float cosine_dist_aligned_##isa(const float* a, const float* b,          \
+                                         std::size_t dim, float inv_a,             \
+                                         float inv_b) {                            \
+    return 1.0f - dot_aligned_##isa##_impl(a, b, dim) * inv_a * inv_b;             \
+  }                                                                                \
+  TARGET float ip_dist_aligned_##isa(const float* a, const float* b,              \
+                                     std::size_t dim, float, float) {              \
+    return -dot_aligned_##isa##_impl(a, b, dim);                                   \
+  }                                                                                \
+  const AlignedKernels kAligned_##isa = {&l2_dist_aligned_##isa,                   \
+                                         &cosine_dist_aligned_##isa,               \
+                                         &ip_dist_aligned_##isa};
+
+// ---------------- Scalar (reference) ----------------
+
+VECDB_INLINE float l2_sq_scalar_impl(const float* a, const float* b, std::size_t dim) {
+  float sum = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+VECDB_INLINE float dot_scalar_impl(const float* a, const float* b, std::size_t dim) {
+  float sum = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+VECDB_DEFINE_X4_FALLBACK(scalar, )
+VECDB_DEFINE_ENTRY_POINTS(scalar, )
+
+// Nothing to gain from alignment without vector loads.
+VECDB_INLINE float l2_sq_aligned_scalar_impl(const float* a, const float* b, std::size_t dim) {
+  return l2_sq_scalar_impl(a, b, dim);
+}
+
+VECDB_INLINE float dot_aligned_scalar_impl(const float* a, const float* b, std::size_t dim) {
+  return dot_scalar_impl(a, b, dim);
+}
+
+VECDB_DEFINE_ALIGNED_ENTRY_POINTS(scalar, )
+
+// SQ8 codes (see ScalarQuantizer): each code byte is widened to float and
+// decoded in-register, so only dim bytes per row are read from memory.
+float sq8_l2_scalar(const float* qm, const float* scale, const std::uint8_t* code,
+                    std::size_t dim) {
+  float sum = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    float d = qm[i] - scale[i] * static_cast<float>(code[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+float sq8_dot_scalar(const float* qs, const std::uint8_t* code, std::size_t dim) {
+  float sum = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) sum += qs[i] * static_cast<float>(code[i]);
+  return sum;
+}
+
+// Binary codes: portable SWAR popcount, used below the AVX2 tier.
+std::uint32_t hamming_scalar(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i < words; ++i) {
+    std::uint64_t x = a[i] ^ b[i];
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    sum += static_cast<std::uint32_t>((x * 0x0101010101010101ull) >> 56);
+  }
+  return sum;
+}
+
+// Half-precision rows (see RowFormat). Each ISA provides half_l2_<isa> and
+// half_dot_<isa>, templated on BF16 (false = IEEE F16); the macro below wraps
+// them into the per-metric HalfDistanceFn entry points.
+#define VECDB_DEFINE_HALF_ENTRY_POINTS(isa, TARGET)                                \
+  template <bool BF16>                                                             \
+  TARGET float half_l2_dist_##isa(const float* q, const std::uint16_t* r,         \
+                                  std::size_t dim, float, float) {                 \
+    return half_l2_##isa<BF16>(q, r, dim);                                         \
+  }                                                                                \
+  template <bool BF16>                                                             \
+  TARGET float half_cosine_dist_##isa(const float* q, const std::uint16_t* r,     \
+                                      std::size_t dim, float inv_q, float inv_r) { \
+    return 1.0f - half_dot_##isa<BF16>(q, r, dim) * inv_q * inv_r;                 \
+  }                                                                                \
+  template <bool BF16>                                                             \
+  TARGET float half_ip_dist_##isa(const float* q, const std::uint16_t* r,         \
+                                  std::size_t dim, float, float) {                 \
+    return -half_dot_##isa<BF16>(q, r, dim);                                       \
+  }                                                                                \
+  const HalfKernels kF16_##isa = {&half_l2_dist_##isa<false>,                      \
+                                  &half_cosine_dist_##isa<false>,                  \
+                                  &half_ip_dist_##isa<false>};                     \
+  const HalfKernels kBF16_##isa = {&half_l2_dist_##isa<true>,                      \
+                                   &half_cosine_dist_##isa<true>,                  \
+                                   &half_ip_dist_##isa<true>};
+
+template <bool BF16>
+VECDB_INLINE float widen_half(std::uint16_t h) {
+  return BF16 ? bf16_to_float(h) : f16_to_float(h);
+}
+
+template <bool BF16>
+float half_l2_scalar(const float* q, const std::uint16_t* r, std::size_t dim) {
+  float sum = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    float d = q[i] - widen_half<BF16>(r[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+template <bool BF16>
+float half_dot_scalar(const float* q, const std::uint16_t* r, std::size_t dim) {
+  float sum = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) sum += q[i] * widen_half<BF16>(r[i]);
+  return sum;
+}
+
+VECDB_DEFINE_HALF_ENTRY_POINTS(scalar, )
+
+#if defined(VECDB_X86)
+
+// ---------------- POPCNT ----------------
+//
+// Every CPU with AVX2 also has POPCNT, so the AVX2 and AVX-512 rows use the
+// hardware instruction. Four accumulators keep the popcnt units busy.
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#define VECDB_POPCNT64(x) static_cast<std::uint32_t>(__popcnt64(x))
+#elif defined(_MSC_VER)
+#define VECDB_POPCNT64(x) \
+  (__popcnt(static_cast<unsigned>(x)) + __popcnt(static_cast<unsigned>((x) >> 32)))
+#else
+#define VECDB_POPCNT64(x) static_cast<std::uint32_t>(__builtin_popcountll(x))
+#endif
+
+VECDB_TARGET_POPCNT std::uint32_t hamming_popcnt(const std::uint64_t* a, const std::uint64_t* b,
+                                                 std::size_t words) {
+  std::uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  std::size_t i = 0;
+  for (; i + 4 <= words; i += 4) {
+    s0 += VECDB_POPCNT64(a[i + 0] ^ b[i + 0]);
+    s1 += VECDB_POPCNT64(a[i + 1] ^ b[i + 1]);
+    s2 += VECDB_POPCNT64(a[i + 2] ^ b[i + 2]);
+    s3 += VECDB_POPCNT64(a[i + 3] ^ b[i + 3]);
+  }
+  for (; i < words; ++i) s0 += VECDB_POPCNT64(a[i] ^ b[i]);
+  return (s0 + s1) + (s2 + s3);
+}
+
+#undef VECDB_POPCNT64
+
+std::uint32_t hamming_sse2(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+  return hamming_scalar(a, b, words);
+}
+std::uint32_t hamming_avx2(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+  return hamming_popcnt(a, b, words);
+}
+std::uint32_t hamming_avx512(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+  return hamming_popcnt(a, b, words);
+}
+
+// ---------------- SSE2 ----------------
+
+VECDB_TARGET_SSE2 inline float hsum_sse2(__m128 v) {
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+VECDB_TARGET_SSE2 VECDB_INLINE float l2_sq_sse2_impl(const float* a, const float* b, std::size_t dim) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+  }
+  for (; i + 4 <= dim; i += 4) {
+    __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+  }
+  float sum = hsum_sse2(_mm_add_ps(acc0, acc1));
+  for (; i < dim; ++i) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+VECDB_TARGET_SSE2 VECDB_INLINE float dot_sse2_impl(const float* a, const float* b, std::size_t dim) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  for (; i + 4 <= dim; i += 4) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  float sum = hsum_sse2(_mm_add_ps(acc0, acc1));
+  for (; i < dim; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+VECDB_DEFINE_X4_FALLBACK(sse2, VECDB_TARGET_SSE2)
+VECDB_DEFINE_ENTRY_POINTS(sse2, VECDB_TARGET_SSE2)
+
+// Padded rows: one 64-byte line (four aligned loads per side) per iteration.
+VECDB_TARGET_SSE2 VECDB_INLINE float l2_sq_aligned_sse2_impl(const float* a, const float* b,
+                                                             std::size_t dim) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (std::size_t i = 0; i < dim; i += 16) {
+    __m128 d0 = _mm_sub_ps(_mm_load_ps(a + i), _mm_load_ps(b + i));
+    __m128 d1 = _mm_sub_ps(_mm_load_ps(a + i + 4), _mm_load_ps(b + i + 4));
+    __m128 d2 = _mm_sub_ps(_mm_load_ps(a + i + 8), _mm_load_ps(b + i + 8));
+    __m128 d3 = _mm_sub_ps(_mm_load_ps(a + i + 12), _mm_load_ps(b + i + 12));
+    acc0 = _mm_add_ps(acc0, _mm_add_ps(_mm_mul_ps(d0, d0), _mm_mul_ps(d1, d1)));
+    acc1 = _mm_add_ps(acc1, _mm_add_ps(_mm_mul_ps(d2, d2), _mm_mul_ps(d3, d3)));
+  }
+  return hsum_sse2(_mm_add_ps(acc0, acc1));
+}
+
+VECDB_TARGET_SSE2 VECDB_INLINE float dot_aligned_sse2_impl(const float* a, const float* b,
+                                                           std::size_t dim) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (std::size_t i = 0; i < dim; i += 16) {
+    acc0 = _mm_add_ps(acc0, _mm_add_ps(_mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)),
+                                       _mm_mul_ps(_mm_load_ps(a + i + 4), _mm_load_ps(b + i + 4))));
+    acc1 = _mm_add_ps(acc1, _mm_add_ps(_mm_mul_ps(_mm_load_ps(a + i + 8), _mm_load_ps(b + i + 8)),
+                                       _mm_mul_ps(_mm_load_ps(a + i + 12), _mm_load_ps(b + i + 12))));
+  }
+  return hsum_sse2(_mm_add_ps(acc0, acc1));
+}
+
+VECDB_DEFINE_ALIGNED_ENTRY_POINTS(sse2, VECDB_TARGET_SSE2)
+
+// 16 code bytes -> 4 x 4 floats (SSE2 has no pmovzx; unpack against zero).
+VECDB_TARGET_SSE2 VECDB_INLINE void widen_u8x16_sse2(const std::uint8_t* p, __m128 out[4]) {
+  const __m128i z = _mm_setzero_si128();
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i lo = _mm_unpacklo_epi8(b, z);
+  __m128i hi = _mm_unpackhi_epi8(b, z);
+  out[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, z));
+  out[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, z));
+  out[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, z));
+  out[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, z));
+}
+
+VECDB_TARGET_SSE2 float sq8_l2_sse2(const float* qm, const float* scale,
+                                    const std::uint8_t* code, std::size_t dim) {
+  __m128 acc = _mm_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    __m128 c[4];
+    widen_u8x16_sse2(code + i, c);
+    for (int j = 0; j < 4; ++j) {
+      __m128 x = _mm_mul_ps(_mm_loadu_ps(scale + i + 4 * j), c[j]);
+      __m128 d = _mm_sub_ps(_mm_loadu_ps(qm + i + 4 * j), x);
+      acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+    }
+  }
+  float sum = hsum_sse2(acc);
+  for (; i < dim; ++i) {
+    float d = qm[i] - scale[i] * static_cast<float>(code[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+VECDB_TARGET_SSE2 float sq8_dot_sse2(const float* qs, const std::uint8_t* code, std::size_t dim) {
+  __m128 acc = _mm_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    __m128 c[4];
+    widen_u8x16_sse2(code + i, c);
+    for (int j = 0; j < 4; ++j) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(qs + i + 4 * j), c[j]));
+  }
+  float sum = hsum_sse2(acc);
+  for (; i < dim; ++i) sum += qs[i] * static_cast<float>(code[i]);
+  return sum;
+}
+
+// SSE2 has no F16C, so F16 falls back to scalar. BF16 -> float is a 16-bit
+// shift, done here by interleaving zeros below each value.
+template <bool BF16>
+VECDB_TARGET_SSE2 float half_l2_sse2(const float* q, const std::uint16_t* r, std::size_t dim) {
+  if (!BF16) return half_l2_scalar<false>(q, r, dim);
+  const __m128i z = _mm_setzero_si128();
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+    __m128 d0 = _mm_sub_ps(_mm_loadu_ps(q + i), _mm_castsi128_ps(_mm_unpacklo_epi16(z, h)));
+    __m128 d1 = _mm_sub_ps(_mm_loadu_ps(q + i + 4), _mm_castsi128_ps(_mm_unpackhi_epi16(z, h)));
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+  }
+  float sum = hsum_sse2(_mm_add_ps(acc0, acc1));
+  for (; i < dim; ++i) {
+    float d = q[i] - bf16_to_float(r[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+template <bool BF16>
+VECDB_TARGET_SSE2 float half_dot_sse2(const float* q, const std::uint16_t* r, std::size_t dim) {
+  if (!BF16) return half_dot_scalar<false>(q, r, dim);
+  const __m128i z = _mm_setzero_si128();
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(q + i),
+                                       _mm_castsi128_ps(_mm_unpacklo_epi16(z, h))));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(q + i + 4),
+                                       _mm_castsi128_ps(_mm_unpackhi_epi16(z, h))));
+  }
+  float sum = hsum_sse2(_mm_add_ps(acc0, acc1));
+  for (; i < dim; ++i) sum += q[i] * bf16_to_float(r[i]);
+  return sum;
+}
+
+VECDB_DEFINE_HALF_ENTRY_POINTS(sse2, VECDB_TARGET_SSE2)
+
+// ---------------- AVX2 + FMA ----------------
+
+VECDB_TARGET_AVX2 inline float hsum_avx2(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  __m128 shuf = _mm_movehdup_ps(lo);
+  __m128 sums = _mm_add_ps(lo, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+VECDB_TARGET_AVX2 VECDB_INLINE float l2_sq_avx2_impl(const float* a, const float* b, std::size_t dim) {
+  // Four independent accumulators hide FMA latency.
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16));
+    __m256 d3 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+    acc2 = _mm256_fmadd_ps(d2, d2, acc2);
+    acc3 = _mm256_fmadd_ps(d3, d3, acc3);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+  }
+  acc0 = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+  float sum = hsum_avx2(acc0);
+  for (; i < dim; ++i) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+VECDB_TARGET_AVX2 VECDB_INLINE float dot_avx2_impl(const float* a, const float* b, std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+    acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+  }
+  acc0 = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+  float sum = hsum_avx2(acc0);
+  for (; i < dim; ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+// One query against four rows: each query chunk is loaded once and feeds
+// four independent FMA chains.
+VECDB_TARGET_AVX2 VECDB_INLINE void l2_sq_x4_avx2_impl(const float* q, const float* const* r,
+                                                       std::size_t dim, float* out) {
+  const float* r0 = r[0];
+  const float* r1 = r[1];
+  const float* r2 = r[2];
+  const float* r3 = r[3];
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m256 qv = _mm256_loadu_ps(q + i);
+    __m256 d0 = _mm256_sub_ps(qv, _mm256_loadu_ps(r0 + i));
+    __m256 d1 = _mm256_sub_ps(qv, _mm256_loadu_ps(r1 + i));
+    __m256 d2 = _mm256_sub_ps(qv, _mm256_loadu_ps(r2 + i));
+    __m256 d3 = _mm256_sub_ps(qv, _mm256_loadu_ps(r3 + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+    acc2 = _mm256_fmadd_ps(d2, d2, acc2);
+    acc3 = _mm256_fmadd_ps(d3, d3, acc3);
+  }
+  float s0 = hsum_avx2(acc0);
+  float s1 = hsum_avx2(acc1);
+  float s2 = hsum_avx2(acc2);
+  float s3 = hsum_avx2(acc3);
+  for (; i < dim; ++i) {
+    float d0 = q[i] - r0[i];
+    float d1 = q[i] - r1[i];
+    float d2 = q[i] - r2[i];
+    float d3 = q[i] - r3[i];
+    s0 += d0 * d0;
+    s1 += d1 * d1;
+    s2 += d2 * d2;
+    s3 += d3 * d3;
+  }
+  out[0] = s0;
+  out[1] = s1;
+  out[2] = s2;
+  out[3] = s3;
+}
+
+VECDB_TARGET_AVX2 VECDB_INLINE void dot_x4_avx2_impl(const float* q, const float* const* r,
+                                                     std::size_t dim, float* out) {
+  const float* r0 = r[0];
+  const float* r1 = r[1];
+  const float* r2 = r[2];
+  const float* r3 = r[3];
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m256 qv = _mm256_loadu_ps(q + i);
+    acc0 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(r0 + i), acc0);
+    acc1 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(r1 + i), acc1);
+    acc2 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(r2 + i), acc2);
+    acc3 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(r3 + i), acc3);
+  }
+  float s0 = hsum_avx2(acc0);
+  float s1 = hsum_avx2(acc1);
+  float s2 = hsum_avx2(acc2);
+  float s3 = hsum_avx2(acc3);
+  for (; i < dim; ++i) {
+    s0 += q[i] * r0[i];
+    s1 += q[i] * r1[i];
+    s2 += q[i] * r2[i];
+    s3 += q[i] * r3[i];
+  }
+  out[0] = s0;
+  out[1] = s1;
+  out[2] = s2;
+  out[3] = s3;
+}
+
+VECDB_DEFINE_ENTRY_POINTS(avx2, VECDB_TARGET_AVX2)
+
+// Padded rows: two lines per iteration into four FMA chains, then at most
+// one trailing line; no scalar tail.
+VECDB_TARGET_AVX2 VECDB_INLINE float l2_sq_aligned_avx2_impl(const float* a, const float* b,
+                                                             std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    __m256 d0 = _mm256_sub_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i));
+    __m256 d1 = _mm256_sub_ps(_mm256_load_ps(a + i + 8), _mm256_load_ps(b + i + 8));
+    __m256 d2 = _mm256_sub_ps(_mm256_load_ps(a + i + 16), _mm256_load_ps(b + i + 16));
+    __m256 d3 = _mm256_sub_ps(_mm256_load_ps(a + i + 24), _mm256_load_ps(b + i + 24));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+    acc2 = _mm256_fmadd_ps(d2, d2, acc2);
+    acc3 = _mm256_fmadd_ps(d3, d3, acc3);
+  }
+  if (i < dim) {
+    __m256 d0 = _mm256_sub_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i));
+    __m256 d1 = _mm256_sub_ps(_mm256_load_ps(a + i + 8), _mm256_load_ps(b + i + 8));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+  }
+  return hsum_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+}
+
+VECDB_TARGET_AVX2 VECDB_INLINE float dot_aligned_avx2_impl(const float* a, const float* b,
+                                                           std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm256_fmadd_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_load_ps(a + i + 8), _mm256_load_ps(b + i + 8), acc1);
+    acc2 = _mm256_fmadd_ps(_mm256_load_ps(a + i + 16), _mm256_load_ps(b + i + 16), acc2);
+    acc3 = _mm256_fmadd_ps(_mm256_load_ps(a + i + 24), _mm256_load_ps(b + i + 24), acc3);
+  }
+  if (i < dim) {
+    acc0 = _mm256_fmadd_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_load_ps(a + i + 8), _mm256_load_ps(b + i + 8), acc1);
+  }
+  return hsum_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+}
+
+VECDB_DEFINE_ALIGNED_ENTRY_POINTS(avx2, VECDB_TARGET_AVX2)
+
+VECDB_TARGET_AVX2 VECDB_INLINE __m256 widen_u8x8_avx2(const std::uint8_t* p) {
+  __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(b));
+}
+
+VECDB_TARGET_AVX2 float sq8_l2_avx2(const float* qm, const float* scale,
+                                    const std::uint8_t* code, std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    // qm - scale * c
+    __m256 d0 = _mm256_fnmadd_ps(_mm256_loadu_ps(scale + i), widen_u8x8_avx2(code + i),
+                                 _mm256_loadu_ps(qm + i));
+    __m256 d1 = _mm256_fnmadd_ps(_mm256_loadu_ps(scale + i + 8), widen_u8x8_avx2(code + i + 8),
+                                 _mm256_loadu_ps(qm + i + 8));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    __m256 d0 = _mm256_fnmadd_ps(_mm256_loadu_ps(scale + i), widen_u8x8_avx2(code + i),
+                                 _mm256_loadu_ps(qm + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+  }
+  float sum = hsum_avx2(_mm256_add_ps(acc0, acc1));
+  for (; i < dim; ++i) {
+    float d = qm[i] - scale[i] * static_cast<float>(code[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+VECDB_TARGET_AVX2 float sq8_dot_avx2(const float* qs, const std::uint8_t* code, std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(qs + i), widen_u8x8_avx2(code + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(qs + i + 8), widen_u8x8_avx2(code + i + 8), acc1);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(qs + i), widen_u8x8_avx2(code + i), acc0);
+  }
+  float sum = hsum_avx2(_mm256_add_ps(acc0, acc1));
+  for (; i < dim; ++i) sum += qs[i] * static_cast<float>(code[i]);
+  return sum;
+}
+
+// 8 half values -> 8 floats: vcvtph2ps for F16, zero-extend + shift for BF16.
+template <bool BF16>
+VECDB_TARGET_AVX2_F16C VECDB_INLINE __m256 widen_half8_avx2(const std::uint16_t* p) {
+  __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  if (BF16) return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+  return _mm256_cvtph_ps(h);
+}
+
+template <bool BF16>
+VECDB_TARGET_AVX2_F16C float half_l2_avx2(const float* q, const std::uint16_t* r, std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(q + i), widen_half8_avx2<BF16>(r + i));
+    __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(q + i + 8), widen_half8_avx2<BF16>(r + i + 8));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(q + i), widen_half8_avx2<BF16>(r + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+  }
+  float sum = hsum_avx2(_mm256_add_ps(acc0, acc1));
+  for (; i < dim; ++i) {
+    float d = q[i] - widen_half<BF16>(r[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+template <bool BF16>
+VECDB_TARGET_AVX2_F16C float half_dot_avx2(const float* q, const std::uint16_t* r, std::size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i), widen_half8_avx2<BF16>(r + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i + 8), widen_half8_avx2<BF16>(r + i + 8), acc1);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(q + i), widen_half8_avx2<BF16>(r + i), acc0);
+  }
+  float sum = hsum_avx2(_mm256_add_ps(acc0, acc1));
+  for (; i < dim; ++i) sum += q[i] * widen_half<BF16>(r[i]);
+  return sum;
+}
+
+VECDB_DEFINE_HALF_ENTRY_POINTS(avx2, VECDB_TARGET_AVX2_F16C)
+
+// ---------------- AVX-512F ----------------
+
+// Folds 512 -> 128 bits with full-mask shuffles. The unmasked forms (and
+// _mm512_reduce_add_ps) trip -Wuninitialized inside some GCC headers.
+VECDB_TARGET_AVX512 inline float hsum_avx512(__m512 v) {
+  const __mmask16 all = 0xFFFF;
+  v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(all, v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(all, v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  __m128 lo = _mm512_maskz_extractf32x4_ps(0xF, v, 0);
+  __m128 shuf = _mm_movehdup_ps(lo);
+  __m128 sums = _mm_add_ps(lo, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+VECDB_TARGET_AVX512 VECDB_INLINE float l2_sq_avx512_impl(const float* a, const float* b, std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  if (i < dim) {
+    // Masked tail: lanes past dim load as zero on both sides.
+    __mmask16 m = static_cast<__mmask16>((1u << (dim - i)) - 1u);
+    __m512 d0 = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+    acc1 = _mm512_fmadd_ps(d0, d0, acc1);
+  }
+  return hsum_avx512(_mm512_add_ps(acc0, acc1));
+}
+
+VECDB_TARGET_AVX512 VECDB_INLINE float dot_avx512_impl(const float* a, const float* b, std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+  }
+  if (i < dim) {
+    __mmask16 m = static_cast<__mmask16>((1u << (dim - i)) - 1u);
+    acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), acc1);
+  }
+  return hsum_avx512(_mm512_add_ps(acc0, acc1));
+}
+
+VECDB_TARGET_AVX512 VECDB_INLINE void l2_sq_x4_avx512_impl(const float* q, const float* const* r,
+                                                           std::size_t dim, float* out) {
+  const float* r0 = r[0];
+  const float* r1 = r[1];
+  const float* r2 = r[2];
+  const float* r3 = r[3];
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  __m512 acc2 = _mm512_setzero_ps();
+  __m512 acc3 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    __m512 qv = _mm512_loadu_ps(q + i);
+    __m512 d0 = _mm512_sub_ps(qv, _mm512_loadu_ps(r0 + i));
+    __m512 d1 = _mm512_sub_ps(qv, _mm512_loadu_ps(r1 + i));
+    __m512 d2 = _mm512_sub_ps(qv, _mm512_loadu_ps(r2 + i));
+    __m512 d3 = _mm512_sub_ps(qv, _mm512_loadu_ps(r3 + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+    acc2 = _mm512_fmadd_ps(d2, d2, acc2);
+    acc3 = _mm512_fmadd_ps(d3, d3, acc3);
+  }
+  if (i < dim) {
+    __mmask16 m = static_cast<__mmask16>((1u << (dim - i)) - 1u);
+    __m512 qv = _mm512_maskz_loadu_ps(m, q + i);
+    __m512 d0 = _mm512_sub_ps(qv, _mm512_maskz_loadu_ps(m, r0 + i));
+    __m512 d1 = _mm512_sub_ps(qv, _mm512_maskz_loadu_ps(m, r1 + i));
+    __m512 d2 = _mm512_sub_ps(qv, _mm512_maskz_loadu_ps(m, r2 + i));
+    __m512 d3 = _mm512_sub_ps(qv, _mm512_maskz_loadu_ps(m, r3 + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+    acc2 = _mm512_fmadd_ps(d2, d2, acc2);
+    acc3 = _mm512_fmadd_ps(d3, d3, acc3);
+  }
+  out[0] = hsum_avx512(acc0);
+  out[1] = hsum_avx512(acc1);
+  out[2] = hsum_avx512(acc2);
+  out[3] = hsum_avx512(acc3);
+}
+
+VECDB_TARGET_AVX512 VECDB_INLINE void dot_x4_avx512_impl(const float* q, const float* const* r,
+                                                         std::size_t dim, float* out) {
+  const float* r0 = r[0];
+  const float* r1 = r[1];
+  const float* r2 = r[2];
+  const float* r3 = r[3];
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  __m512 acc2 = _mm512_setzero_ps();
+  __m512 acc3 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    __m512 qv = _mm512_loadu_ps(q + i);
+    acc0 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r0 + i), acc0);
+    acc1 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r1 + i), acc1);
+    acc2 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r2 + i), acc2);
+    acc3 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r3 + i), acc3);
+  }
+  if (i < dim) {
+    __mmask16 m = static_cast<__mmask16>((1u << (dim - i)) - 1u);
+    __m512 qv = _mm512_maskz_loadu_ps(m, q + i);
+    acc0 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(m, r0 + i), acc0);
+    acc1 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(m, r1 + i), acc1);
+    acc2 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(m, r2 + i), acc2);
+    acc3 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(m, r3 + i), acc3);
+  }
+  out[0] = hsum_avx512(acc0);
+  out[1] = hsum_avx512(acc1);
+  out[2] = hsum_avx512(acc2);
+  out[3] = hsum_avx512(acc3);
+}
+
+VECDB_DEFINE_ENTRY_POINTS(avx512, VECDB_TARGET_AVX512)
+
+// Padded rows: one aligned load per line, so no masked tail.
+VECDB_TARGET_AVX512 VECDB_INLINE float l2_sq_aligned_avx512_impl(const float* a, const float* b,
+                                                                 std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    __m512 d0 = _mm512_sub_ps(_mm512_load_ps(a + i), _mm512_load_ps(b + i));
+    __m512 d1 = _mm512_sub_ps(_mm512_load_ps(a + i + 16), _mm512_load_ps(b + i + 16));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+  }
+  if (i < dim) {
+    __m512 d0 = _mm512_sub_ps(_mm512_load_ps(a + i), _mm512_load_ps(b + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  return hsum_avx512(_mm512_add_ps(acc0, acc1));
+}
+
+VECDB_TARGET_AVX512 VECDB_INLINE float dot_aligned_avx512_impl(const float* a, const float* b,
+                                                               std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_load_ps(a + i), _mm512_load_ps(b + i), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_load_ps(a + i + 16), _mm512_load_ps(b + i + 16), acc1);
+  }
+  if (i < dim) {
+    acc0 = _mm512_fmadd_ps(_mm512_load_ps(a + i), _mm512_load_ps(b + i), acc0);
+  }
+  return hsum_avx512(_mm512_add_ps(acc0, acc1));
+}
+
+VECDB_DEFINE_ALIGNED_ENTRY_POINTS(avx512, VECDB_TARGET_AVX512)
+
+// maskz forms for the same header-warning reason as hsum_avx512.
+VECDB_TARGET_AVX512 VECDB_INLINE __m512 widen_u8x16_avx512(const std::uint8_t* p) {
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  return _mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_maskz_cvtepu8_epi32(0xFFFF, b));
+}
+
+VECDB_TARGET_AVX512 float sq8_l2_avx512(const float* qm, const float* scale,
+                                        const std::uint8_t* code, std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    __m512 d0 = _mm512_fnmadd_ps(_mm512_loadu_ps(scale + i), widen_u8x16_avx512(code + i),
+                                 _mm512_loadu_ps(qm + i));
+    __m512 d1 = _mm512_fnmadd_ps(_mm512_loadu_ps(scale + i + 16),
+                                 widen_u8x16_avx512(code + i + 16), _mm512_loadu_ps(qm + i + 16));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    __m512 d0 = _mm512_fnmadd_ps(_mm512_loadu_ps(scale + i), widen_u8x16_avx512(code + i),
+                                 _mm512_loadu_ps(qm + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  float sum = hsum_avx512(_mm512_add_ps(acc0, acc1));
+  for (; i < dim; ++i) {
+    float d = qm[i] - scale[i] * static_cast<float>(code[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+VECDB_TARGET_AVX512 float sq8_dot_avx512(const float* qs, const std::uint8_t* code,
+                                         std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(qs + i), widen_u8x16_avx512(code + i), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(qs + i + 16), widen_u8x16_avx512(code + i + 16), acc1);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(qs + i), widen_u8x16_avx512(code + i), acc0);
+  }
+  float sum = hsum_avx512(_mm512_add_ps(acc0, acc1));
+  for (; i < dim; ++i) sum += qs[i] * static_cast<float>(code[i]);
+  return sum;
+}
+
+// 16 half values -> 16 floats. vcvtph2ps zmm is part of AVX-512F. BF16 is
+// widened with a shift rather than AVX512_BF16's vdpbf16ps, which would also
+// round the query to bf16.
+template <bool BF16>
+VECDB_TARGET_AVX512 VECDB_INLINE __m512 widen_half16_avx512(const std::uint16_t* p) {
+  __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  if (BF16) {
+    return _mm512_castsi512_ps(
+        _mm512_maskz_slli_epi32(0xFFFF, _mm512_maskz_cvtepu16_epi32(0xFFFF, h), 16));
+  }
+  return _mm512_maskz_cvtph_ps(0xFFFF, h);
+}
+
+template <bool BF16>
+VECDB_TARGET_AVX512 float half_l2_avx512(const float* q, const std::uint16_t* r, std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(q + i), widen_half16_avx512<BF16>(r + i));
+    __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(q + i + 16), widen_half16_avx512<BF16>(r + i + 16));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(q + i), widen_half16_avx512<BF16>(r + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  float sum = hsum_avx512(_mm512_add_ps(acc0, acc1));
+  for (; i < dim; ++i) {
+    float d = q[i] - widen_half<BF16>(r[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+template <bool BF16>
+VECDB_TARGET_AVX512 float half_dot_avx512(const float* q, const std::uint16_t* r, std::size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i), widen_half16_avx512<BF16>(r + i), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i + 16), widen_half16_avx512<BF16>(r + i + 16),
+                           acc1);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(q + i), widen_half16_avx512<BF16>(r + i), acc0);
+  }
+  float sum = hsum_avx512(_mm512_add_ps(acc0, acc1));
+  for (; i < dim; ++i) sum += q[i] * widen_half<BF16>(r[i]);
+  return sum;
+}
+
+VECDB_DEFINE_HALF_ENTRY_POINTS(avx512, VECDB_TARGET_AVX512)
+
+// ---------------- CPUID ----------------
+
+#if defined(_MSC_VER)
+
+bool cpu_has(int leaf, int subleaf, int reg, int bit) {
+  int regs[4] = {0, 0, 0, 0};
+  __cpuidex(regs, leaf, subleaf);
+  return (regs[reg] >> bit) & 1;
+}
+
+Level detect_x86() {
+  int max_leaf[4] = {0, 0, 0, 0};
+  __cpuid(max_leaf, 0);
+
+  if (!cpu_has(1, 0, 3, 26)) return Level::Scalar;  // EDX.SSE2
+  // AVX state must also be enabled by the OS (OSXSAVE + XCR0).
+  if (!cpu_has(1, 0, 2, 27)) return Level::SSE2;    // ECX.OSXSAVE
+  unsigned long long xcr0 = _xgetbv(0);
+  if ((xcr0 & 0x6) != 0x6) return Level::SSE2;
+  if (max_leaf[0] < 7) return Level::SSE2;
+
+  bool fma = cpu_has(1, 0, 2, 12);                  // ECX.FMA
+  bool f16c = cpu_has(1, 0, 2, 29);                 // ECX.F16C
+  bool avx2 = cpu_has(7, 0, 1, 5);                  // EBX.AVX2
+  bool avx512f = cpu_has(7, 0, 1, 16);              // EBX.AVX512F
+  if (avx512f && fma && (xcr0 & 0xE6) == 0xE6) return Level::AVX512;
+  if (avx2 && fma && f16c) return Level::AVX2;
+  return Level::SSE2;
+}
+
+#else
+
+Level detect_x86() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma")) return Level::AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      __builtin_cpu_supports("f16c")) {
+    return Level::AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) return Level::SSE2;
+  return Level::Scalar;
+}
+
+#endif  // _MSC_VER
+
+#endif  // VECDB_X86
+
+#define VECDB_KERNEL_ROW(level, isa)                                            \
+  {level, #isa, &l2_sq_##isa, &dot_##isa, &l2_sq_bounded_##isa,                \
+   &l2_batch_bounded_##isa, &l2_dist_##isa, &cosine_dist_##isa, &ip_dist_##isa, \
+   &l2_batch_##isa, &cosine_batch_##isa, &ip_batch_##isa, &sq8_l2_##isa,         \
+   &sq8_dot_##isa, &hamming_##isa, kF16_##isa, kBF16_##isa, kAligned_##isa,      \
+   kFixed_##isa}
+
+static_assert(sizeof(kFixed_scalar) / sizeof(kFixed_scalar[0]) == kNumFixedDims,
+              "VECDB_DEFINE_FIXED_ENTRY_POINTS must cover kFixedDims");
+
+const Kernels kTable[] = {
+    VECDB_KERNEL_ROW(Level::Scalar, scalar),
+#if defined(VECDB_X86)
+    VECDB_KERNEL_ROW(Level::SSE2, sse2),
+    VECDB_KERNEL_ROW(Level::AVX2, avx2),
+    VECDB_KERNEL_ROW(Level::AVX512, avx512),
+#endif
+};
+
+}  // namespace
+
+Level detect() {
+#if defined(VECDB_X86)
+  return detect_x86();
+#else
+  return Level::Scalar;
+#endif
+}
+
+const Kernels& kernels(Level level) {
+  constexpr std::size_t n = sizeof(kTable) / sizeof(kTable[0]);
+  std::size_t i = static_cast<std::size_t>(level);
+  return kTable[i < n ? i : 0];
+}
+
+const Kernels& active() {
+  // Resolved once; thread-safe under C++11 static initialization rules.
+  static const Kernels& k = kernels(detect());
+  return k;
+}
+
+}  // namespace vecdb::simd
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Distance.h"
+
+namespace vecdb::simd {
+
+// Instruction set tiers for the distance kernels, lowest to highest.
+enum class Level {
+  Scalar = 0,
+  SSE2 = 1,
+  AVX2 = 2,    // AVX2 + FMA + F16C
+  AVX512 = 3   // AVX-512F (+ FMA)
+};
+
+// Raw kernel: reduces two float arrays of length dim to a single float.
+using KernelFn = float (*)(const float* a, const float* b, std::size_t dim);
+
+// SQ8 code kernels (see ScalarQuantizer). Codes are widened to float in-register:
+//   sq8_l2:  sum_i (qm[i] - scale[i] * code[i])^2
+//   sq8_dot: sum_i qs[i] * code[i]
+using Sq8L2Fn = float (*)(const float* qm, const float* scale, const std::uint8_t* code,
+                          std::size_t dim);
+using Sq8DotFn = float (*)(const float* qs, const std::uint8_t* code, std::size_t dim);
+
+// Binary code kernel (see BinaryQuantizer): number of differing bits between
+// two packed bit arrays of `words` 64-bit words.
+using HammingFn = std::uint32_t (*)(const std::uint64_t* a, const std::uint64_t* b,
+                                    std::size_t words);
+
+// Metric entry points for rows stored in one half format (see RowFormat).
+struct HalfKernels {
+  HalfDistanceFn l2_dist;      // l2_sq against the widened row
+  HalfDistanceFn cosine_dist;  // 1 - dot * inv_query * inv_row
+  HalfDistanceFn ip_dist;      // -dot
+};
+
+// Metric entry points for padded rows (VectorStore with pad_rows): dim must be
+// a multiple of kRowPad and both pointers kCacheLine-aligned, so the loops use
+// aligned loads over whole cache lines and skip the remainder handling.
+struct AlignedKernels {
+  DistanceFn l2_dist;
+  DistanceFn cosine_dist;
+  DistanceFn ip_dist;
+};
+
+// Kernels compiled for one fixed dimension (constant trip count, no tail).
+// The dim argument of these functions is ignored.
+struct FixedKernels {
+  std::size_t dim;
+  KernelFn l2_sq;
+  KernelFn dot;
+  DistanceFn l2_dist;
+  DistanceFn cosine_dist;
+  DistanceFn ip_dist;
+  BatchDistanceFn l2_batch;
+  BatchDistanceFn cosine_batch;
+  BatchDistanceFn ip_batch;
+};
+
+// Granularity of the early-abandon check in l2_sq_bounded. Each check costs a
+// horizontal sum, so it is done per block rather than per vector register.
+constexpr std::size_t kAbandonBlock = 256;
+
+// Dimensions with a FixedKernels instantiation at every level.
+constexpr std::size_t kFixedDims[] = {128, 384, 768, 1024, 1536};
+constexpr std::size_t kNumFixedDims = sizeof(kFixedDims) / sizeof(kFixedDims[0]);
+
+// One row of the dispatch table. Every entry is always non-null.
+struct Kernels {
+  Level level;
+  const char* name;
+  KernelFn l2_sq;
+  KernelFn dot;
+
+  // Early-abandon l2_sq: the bound is checked every kAbandonBlock floats.
+  float (*l2_sq_bounded)(const float* a, const float* b, std::size_t dim, float bound);
+  BoundedBatchDistanceFn l2_batch_bounded;  // stops a group of 4 once all exceed it
+
+  // Metric entry points (see Distance::resolve).
+  DistanceFn l2_dist;      // L2: l2_sq, norms ignored
+  DistanceFn cosine_dist;  // COSINE: 1 - dot * inv_a * inv_b
+  DistanceFn ip_dist;      // IP: -dot, norms ignored
+
+  // Batched metric entry points (see Distance::resolve_batch).
+  BatchDistanceFn l2_batch;
+  BatchDistanceFn cosine_batch;
+  BatchDistanceFn ip_batch;
+
+  // Quantized-code kernels.
+  Sq8L2Fn sq8_l2;
+  Sq8DotFn sq8_dot;
+  HammingFn hamming;
+
+  // Half-precision rows: F16 needs F16C (AVX2 tier and up, scalar below);
+  // BF16 widens with an integer shift at every level.
+  HalfKernels f16;
+  HalfKernels bf16;
+
+  // Padded-row kernels (see Distance::resolve_aligned).
+  AlignedKernels aligned;
+
+  // kNumFixedDims entries, one per kFixedDims value.
+  const FixedKernels* fixed;
+
+  // Fixed-dimension kernels for dim, or nullptr if dim is not specialized.
+  const FixedKernels* find_fixed(std::size_t dim) const {
+    for (std::size_t i = 0; i < kNumFixedDims; ++i) {
+      if (fixed[i].dim == dim) return &fixed[i];
+    }
+    return nullptr;
+  }
+};
+
+// Highest level supported by both the build and the running CPU (CPUID).
+Level detect();
+
+// Kernel table for a level. Levels above detect() must not be called.
+const Kernels& kernels(Level level);
+
+// Kernel table chosen once at startup (kernels(detect())).
+const Kernels& active();
+
+}  // namespace vecdb::simd
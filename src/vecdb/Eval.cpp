@@ -39,24 +39,38 @@ EvalReport Evaluator::evaluate(const std::vector<std::vector<float>>& queries,
                                std::size_t k,
                                const SearchFn& truth,
                                const SearchFn& approx) const {
+  std::vector<std::vector<SearchResult>> gt;
+  gt.reserve(queries.size());
+  for (const auto& q : queries) gt.push_back(truth(q, k));
+  return score(queries, k, gt, approx);
+}
+
+EvalReport Evaluator::evaluate(const std::vector<std::vector<float>>& queries,
+                               std::size_t k,
+                               const Bruteforce& truth,
+                               const SearchFn& approx) const {
+  return score(queries, k, truth.search_batch(queries, k), approx);
+}
+
+EvalReport Evaluator::score(const std::vector<std::vector<float>>& queries,
+                            std::size_t k,
+                            const std::vector<std::vector<SearchResult>>& truth,
+                            const SearchFn& approx) {
   using clock = std::chrono::steady_clock;
 
   double total_recall = 0.0;
   double total_ms = 0.0;
 
-  for (const auto& q : queries) {
-    // ground truth
-    auto gt = truth(q, k);
-
+  for (std::size_t qi = 0; qi < queries.size(); ++qi) {
     // approx timing
     auto t0 = clock::now();
-    auto ap = approx(q, k);
+    auto ap = approx(queries[qi], k);
     auto t1 = clock::now();
 
     double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
     total_ms += ms;
 
-    total_recall += recall_at_k(gt, ap, k);
+    total_recall += recall_at_k(truth[qi], ap, k);
   }
 
   EvalReport r;
@@ -5,6 +5,7 @@
 #include <vector>
 #include <functional>
 
+#include "Bruteforce.h"
 #include "SearchResult.h"
 #include "VectorStore.h"
 
@@ -35,12 +36,25 @@ class Evaluator {
                       const SearchFn& truth,
                       const SearchFn& approx) const;
 
+  // Same, but ground truth for all queries comes from one truth.search_batch()
+  // call (tiled and multithreaded) instead of one search per query.
+  EvalReport evaluate(const std::vector<std::vector<float>>& queries,
+                      std::size_t k,
+                      const Bruteforce& truth,
+                      const SearchFn& approx) const;
+
   // Utility: compute recall@k for a single query result set
   static double recall_at_k(const std::vector<SearchResult>& truth,
                             const std::vector<SearchResult>& approx,
                             std::size_t k);
 
  private:
+  // Times approx on every query and scores it against precomputed truth.
+  static EvalReport score(const std::vector<std::vector<float>>& queries,
+                          std::size_t k,
+                          const std::vector<std::vector<SearchResult>>& truth,
+                          const SearchFn& approx);
+
   const VectorStore& store_;
 };
 
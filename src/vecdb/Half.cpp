@@ -0,0 +1,70 @@
+#include "Half.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace vecdb {
+
+const char* row_format_to_string(RowFormat f) {
+  switch (f) {
+    case RowFormat::F16:
+      return "f16";
+    case RowFormat::BF16:
+      return "bf16";
+    case RowFormat::F32:
+    default:
+      return "f32";
+  }
+}
+
+RowFormat row_format_from_string(const std::string& s) {
+  if (s.empty() || s == "f32") return RowFormat::F32;
+  if (s == "f16") return RowFormat::F16;
+  if (s == "bf16") return RowFormat::BF16;
+  throw std::invalid_argument("unknown row format: " + s);
+}
+
+std::uint16_t float_to_f16(float f) {
+  std::uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  const std::uint16_t sign = static_cast<std::uint16_t>((x >> 16) & 0x8000u);
+  const std::uint32_t ax = x & 0x7FFFFFFFu;
+
+  if (ax >= 0x7F800000u) {
+    // Inf stays Inf; NaN keeps a quiet payload bit.
+    return static_cast<std::uint16_t>(sign | 0x7C00u | (ax > 0x7F800000u ? 0x200u : 0u));
+  }
+  if (ax >= 0x477FF000u) return static_cast<std::uint16_t>(sign | 0x7C00u);  // rounds past 65504
+
+  if (ax < 0x38800000u) {
+    // Below the smallest normal (2^-14): the subnormal mantissa is |f| * 2^24,
+    // which is exact in float, so nearbyint() does the round-to-even.
+    float a;
+    std::memcpy(&a, &ax, sizeof(a));
+    return static_cast<std::uint16_t>(sign | static_cast<std::uint32_t>(std::nearbyint(a * 16777216.0f)));
+  }
+
+  const std::uint32_t mant = ax & 0x7FFFFFu;
+  std::uint32_t h = (((ax >> 23) - 112) << 10) | (mant >> 13);
+  const std::uint32_t rem = mant & 0x1FFFu;
+  if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) ++h;  // a carry bumps the exponent
+  return static_cast<std::uint16_t>(sign | h);
+}
+
+void encode_half_row(RowFormat f, const float* in, std::size_t dim, std::uint16_t* out) {
+  if (f == RowFormat::BF16) {
+    for (std::size_t i = 0; i < dim; ++i) out[i] = float_to_bf16(in[i]);
+  } else {
+    for (std::size_t i = 0; i < dim; ++i) out[i] = float_to_f16(in[i]);
+  }
+}
+
+void decode_half_row(RowFormat f, const std::uint16_t* in, std::size_t dim, float* out) {
+  if (f == RowFormat::BF16) {
+    for (std::size_t i = 0; i < dim; ++i) out[i] = bf16_to_float(in[i]);
+  } else {
+    for (std::size_t i = 0; i < dim; ++i) out[i] = f16_to_float(in[i]);
+  }
+}
+
+}  // namespace vecdb
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace vecdb {
+
+// Element type of the rows a VectorStore keeps in memory and in vectors.bin.
+// Half formats halve RAM, file size and memory traffic per distance; queries
+// stay float and rows are widened inside the distance kernels.
+enum class RowFormat {
+  F32,   // IEEE float32 (default)
+  F16,   // IEEE binary16: 10-bit mantissa, range +-65504
+  BF16   // bfloat16: float32's exponent with a 7-bit mantissa
+};
+
+// "f32" / "f16" / "bf16". row_format_from_string throws std::invalid_argument.
+const char* row_format_to_string(RowFormat f);
+RowFormat row_format_from_string(const std::string& s);
+
+// Bytes per element in storage.
+inline std::size_t row_format_bytes(RowFormat f) { return f == RowFormat::F32 ? 4 : 2; }
+
+// float -> binary16, round to nearest even; overflow saturates to infinity.
+std::uint16_t float_to_f16(float f);
+
+inline float f16_to_float(std::uint16_t h) {
+  const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000u) << 16;
+  const std::uint32_t exp = (h >> 10) & 0x1Fu;
+  const std::uint32_t mant = h & 0x3FFu;
+  std::uint32_t bits;
+  if (exp == 0) {
+    // Zero or subnormal: mant * 2^-24.
+    float f = static_cast<float>(mant) * (1.0f / 16777216.0f);
+    std::memcpy(&bits, &f, sizeof(bits));
+    bits |= sign;
+  } else if (exp == 31) {
+    bits = sign | 0x7F800000u | (mant << 13);
+  } else {
+    bits = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float out;
+  std::memcpy(&out, &bits, sizeof(out));
+  return out;
+}
+
+// float -> bfloat16, round to nearest even (NaN stays NaN).
+inline std::uint16_t float_to_bf16(float f) {
+  std::uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  if ((x & 0x7FFFFFFFu) > 0x7F800000u) return static_cast<std::uint16_t>((x >> 16) | 0x40u);
+  x += 0x7FFFu + ((x >> 16) & 1u);
+  return static_cast<std::uint16_t>(x >> 16);
+}
+
+inline float bf16_to_float(std::uint16_t b) {
+  const std::uint32_t x = static_cast<std::uint32_t>(b) << 16;
+  float out;
+  std::memcpy(&out, &x, sizeof(out));
+  return out;
+}
+
+// Convert a row of dim floats to / from a half format (F16 or BF16).
+void encode_half_row(RowFormat f, const float* in, std::size_t dim, std::uint16_t* out);
+void decode_half_row(RowFormat f, const std::uint16_t* in, std::size_t dim, float* out);
+
+}  // namespace vecdb
@@ -1,10 +1,13 @@
 #include "Hnsw.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
-#include <queue>
 #include <stdexcept>
 #include <limits>
+#include <thread>
+
+#include "Visited.h"
 
 namespace vecdb {
 
@@ -23,6 +26,20 @@ struct MaxHeap {
   bool operator()(const Cand& a, const Cand& b) const { return a.dist < b.dist; }
 };
 
+// Binary heaps over a caller-owned vector (std::priority_queue cannot hand
+// its storage back for reuse).
+template <class Cmp>
+static inline void heap_push(std::vector<Cand>& h, Cand c) {
+  h.push_back(c);
+  std::push_heap(h.begin(), h.end(), Cmp{});
+}
+
+template <class Cmp>
+static inline void heap_pop(std::vector<Cand>& h) {
+  std::pop_heap(h.begin(), h.end(), Cmp{});
+  h.pop_back();
+}
+
 static inline unsigned lcg_next(unsigned& state) {
   state = state * 1664525u + 1013904223u;
   return state;
@@ -35,14 +52,91 @@ static inline float lcg_uniform01(unsigned& state) {
 
 }  // namespace
 
+struct Hnsw::SearchContext {
+  Visited visited;
+  std::vector<Cand> candidates;  // min-heap (MinHeap): frontier to expand
+  std::vector<Cand> results;     // max-heap (MaxHeap): best ef so far
+  std::vector<std::size_t> batch_idx;
+  std::vector<const float*> batch_rows;
+  std::vector<float> batch_inv;
+  std::vector<float> batch_dist;
+};
+
+class Hnsw::ContextLease {
+ public:
+  explicit ContextLease(const Hnsw& owner) : owner_(owner) {
+    {
+      std::lock_guard<std::mutex> lock(owner_.ctx_mtx_);
+      if (!owner_.ctx_pool_.empty()) {
+        ctx_ = std::move(owner_.ctx_pool_.back());
+        owner_.ctx_pool_.pop_back();
+      }
+    }
+    if (!ctx_) ctx_ = std::make_unique<SearchContext>();
+  }
+
+  ~ContextLease() {
+    std::lock_guard<std::mutex> lock(owner_.ctx_mtx_);
+    owner_.ctx_pool_.push_back(std::move(ctx_));
+  }
+
+  ContextLease(const ContextLease&) = delete;
+  ContextLease& operator=(const ContextLease&) = delete;
+
+  SearchContext& get() { return *ctx_; }
+
+ private:
+  const Hnsw& owner_;
+  std::unique_ptr<SearchContext> ctx_;
+};
+
+Hnsw::Hnsw(const VectorStore& store, Metric metric, Params params)
+    : store_(store),
+      metric_(metric),
+      params_(params),
+      dist_(store.padded_rows() ? Distance::resolve_aligned(metric, store.row_stride())
+                                : Distance::resolve(metric, store.dim())),
+      batch_dist_(Distance::resolve_batch(metric, store.row_stride())),
+      bounded_dist_(Distance::resolve_bounded(metric)),
+      half_dist_(Distance::resolve_half(metric, store.row_format())),
+      uses_norms_(metric == Metric::COSINE),
+      level0_stride_(params.M0 + 1),
+      upper_stride_(params.M + 1) {}
+
+Hnsw::~Hnsw() = default;
+
 void Hnsw::ensure_node(std::size_t index) {
-  if (index >= graph_.size()) graph_.resize(index + 1);
+  if (index < levels_.size()) return;
+  if (index >= std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("Hnsw: slot index does not fit a 32-bit neighbor id");
+  }
+  levels_.resize(index + 1, -1);
+  sized_levels_.resize(index + 1, -1);
+  upper_run_.resize(index + 1, 0);
+  level0_.resize((index + 1) * level0_stride_, 0);
 }
 
-int Hnsw::node_level(std::size_t index) const {
-  if (index >= graph_.size()) return -1;
-  if (graph_[index].links.empty()) return -1;
-  return static_cast<int>(graph_[index].links.size()) - 1;
+void Hnsw::alloc_levels(std::size_t index, int lvl) {
+  if (lvl > 0 && lvl > sized_levels_[index]) {
+    const std::size_t run = upper_.size() / upper_stride_;
+    if (run + static_cast<std::size_t>(lvl) > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error("Hnsw: upper-level link pool is full");
+    }
+    upper_run_[index] = static_cast<std::uint32_t>(run);
+    upper_.resize(upper_.size() + static_cast<std::size_t>(lvl) * upper_stride_, 0);
+  }
+  sized_levels_[index] = static_cast<std::int8_t>(std::max<int>(lvl, sized_levels_[index]));
+  levels_[index] = static_cast<std::int8_t>(lvl);
+  for (int l = 0; l <= lvl; ++l) links(index, l)[0] = 0;
+}
+
+int Hnsw::insert_level(std::size_t index) {
+  return sized_levels_[index] >= 0 ? sized_levels_[index] : random_level();
+}
+
+void Hnsw::set_links(std::uint32_t* list, const std::vector<std::size_t>& ids) {
+  list[0] = static_cast<std::uint32_t>(ids.size());
+  for (std::size_t j = 0; j < ids.size(); ++j) list[j + 1] = static_cast<std::uint32_t>(ids[j]);
 }
 
 int Hnsw::random_level() {
@@ -60,78 +154,145 @@ int Hnsw::random_level() {
   return lvl;
 }
 
-std::vector<SearchResult> Hnsw::search_level(const float* query_ptr,
+std::vector<SearchResult> Hnsw::search_level(SearchContext& ctx,
+                                            const float* query_ptr,
+                                            float query_inv,
                                             std::size_t entry,
                                             int level,
-                                            std::size_t ef) const {
+                                            std::size_t ef,
+                                            const CodeQuery* codes) const {
+  // Removed slots are tombstones: their rows stay in the store and they keep
+  // routing the traversal (dropping them could cut the graph apart), but they
+  // never enter the results. Without any, this is plain HNSW best-first search.
+  const bool has_dead = store_.alive_count() < store_.size();
+
+  // There are never more than alive_count() live results to wait for.
+  ef = std::min(ef, store_.alive_count());
   if (!has_entry_ || ef == 0) return {};
-  if (!store_.is_alive(entry)) return {};
 
   auto dist_to = [&](std::size_t idx) -> float {
-    const float* v = store_.get_ptr(idx);
-    if (!v) return std::numeric_limits<float>::infinity();
-    return Distance::distance(metric_, query_ptr, v, store_.dim());
+    if (codes) return code_distance(*codes, idx);
+    return query_distance(query_ptr, query_inv, idx);
+  };
+  auto by_distance = [](const SearchResult& a, const SearchResult& b) {
+    return a.distance < b.distance;
   };
 
+  // When ef covers every live slot (a collection mostly removed), the walk
+  // below would have to pass through the tombstones to reach all of them.
+  // Scoring the live nodes on this level directly gives the same answer in
+  // alive_count() distances.
+  if (has_dead && ef == store_.alive_count()) {
+    std::vector<SearchResult> out;
+    out.reserve(ef);
+    store_.alive().for_each([&](std::size_t i) {
+      if (node_level(i) >= level) out.push_back({i, dist_to(i)});
+    });
+    std::sort(out.begin(), out.end(), by_distance);
+    return out;
+  }
+
   // --- visited: stamp-array ---
-  visited_.start(store_.size());
+  Visited& visited = ctx.visited;
+  visited.start(store_.size());
 
   float entry_d = dist_to(entry);
 
-  std::priority_queue<Cand, std::vector<Cand>, MinHeap> candidates;
-  std::priority_queue<Cand, std::vector<Cand>, MaxHeap> results;
+  std::vector<Cand>& candidates = ctx.candidates;
+  std::vector<Cand>& results = ctx.results;
+  candidates.clear();
+  results.clear();
+
+  heap_push<MinHeap>(candidates, {entry, entry_d});
+  if (store_.is_alive(entry)) heap_push<MaxHeap>(results, {entry, entry_d});
+  visited.set(entry);
 
-  candidates.push({entry, entry_d});
-  results.push({entry, entry_d});
-  visited_.set(entry);
+  // Distance of the worst result so far; +inf until one is found.
+  float bound = results.empty() ? std::numeric_limits<float>::infinity() : entry_d;
+
+  // Unvisited neighbors of the expanded node are collected first and
+  // scored with one batched kernel call.
+  std::vector<std::size_t>& batch_idx = ctx.batch_idx;
+  std::vector<const float*>& batch_rows = ctx.batch_rows;
+  std::vector<float>& batch_inv = ctx.batch_inv;
+  std::vector<float>& batch_dist = ctx.batch_dist;
 
   while (!candidates.empty()) {
-    Cand c = candidates.top();
-    candidates.pop();
+    Cand c = candidates.front();
+    heap_pop<MinHeap>(candidates);
 
-    Cand worst = results.top();
-    if (c.dist > worst.dist) break;
+    // With tombstones around, keep going until ef live results are found.
+    if (c.dist > bound && (results.size() >= ef || !has_dead)) break;
 
     int nl = node_level(c.index);
     if (nl < level) continue;
 
-    const auto& nbrs = graph_[c.index].links[level];
-    for (std::size_t nb : nbrs) {
-      if (!store_.is_alive(nb)) continue;
-      if (visited_.test_and_set(nb)) continue;
+    batch_idx.clear();
+    batch_rows.clear();
+    batch_inv.clear();
+    {
+      std::unique_lock<std::mutex> lock;
+      if (parallel_build_) lock = std::unique_lock<std::mutex>(link_lock(c.index));
+      const std::uint32_t* list = links(c.index, level);
+      for (std::uint32_t j = 1; j <= list[0]; ++j) {
+        const std::size_t nb = list[j];
+        if (visited.test_and_set(nb)) continue;
+        batch_idx.push_back(nb);
+        if (codes || half_dist_) continue;
+        batch_rows.push_back(store_.row_ptr(nb));
+        if (uses_norms_) batch_inv.push_back(store_.inv_norm(nb));
+      }
+    }
+    if (batch_idx.empty()) continue;
 
-      float d = dist_to(nb);
+    batch_dist.resize(batch_idx.size());
+    if (codes) {
+      for (std::size_t j = 0; j < batch_idx.size(); ++j) {
+        batch_dist[j] = code_distance(*codes, batch_idx[j]);
+      }
+    } else if (half_dist_) {
+      for (std::size_t j = 0; j < batch_idx.size(); ++j) {
+        batch_dist[j] = query_distance(query_ptr, query_inv, batch_idx[j]);
+      }
+    } else if (bounded_dist_ && results.size() >= ef) {
+      // With ef results in hand a neighbor only matters if it beats the
+      // current worst, so the kernel may stop early on the rest.
+      bounded_dist_(query_ptr, batch_rows.data(), batch_idx.size(), store_.row_stride(),
+                    bound, batch_dist.data());
+    } else {
+      batch_dist_(query_ptr, batch_rows.data(), batch_idx.size(), store_.row_stride(), query_inv,
+                  uses_norms_ ? batch_inv.data() : nullptr, batch_dist.data());
+    }
+
+    for (std::size_t j = 0; j < batch_idx.size(); ++j) {
+      const std::size_t nb = batch_idx[j];
+      const float d = batch_dist[j];
 
-      if (results.size() < ef) {
-        candidates.push({nb, d});
-        results.push({nb, d});
-      } else if (d < results.top().dist) {
-        candidates.push({nb, d});
-        results.push({nb, d});
-        if (results.size() > ef) results.pop();
+      if (results.size() < ef || d < bound) {
+        heap_push<MinHeap>(candidates, {nb, d});
+        if (!store_.is_alive(nb)) continue;
+        heap_push<MaxHeap>(results, {nb, d});
+        if (results.size() > ef) heap_pop<MaxHeap>(results);
+        bound = results.front().dist;
       }
     }
   }
 
   std::vector<SearchResult> out;
   out.reserve(results.size());
-  while (!results.empty()) {
-    auto x = results.top();
-    results.pop();
-    out.push_back({x.index, x.dist});
-  }
+  for (const Cand& x : results) out.push_back({x.index, x.dist});
 
-  std::sort(out.begin(), out.end(),
-            [](const SearchResult& a, const SearchResult& b) {
-              return a.distance < b.distance;
-            });
+  std::sort(out.begin(), out.end(), by_distance);
   return out;
 }
 
-std::size_t Hnsw::greedy_descent(const float* query_ptr,
+std::size_t Hnsw::greedy_descent(SearchContext& ctx,
+                                const float* query_ptr,
+                                float query_inv,
                                 std::size_t entry,
-                                int level) const {
-  auto res = search_level(query_ptr, entry, level, /*ef=*/1);
+                                int level,
+                                const CodeQuery* codes) const {
+  auto res = search_level(ctx, query_ptr, query_inv, entry, level, /*ef=*/1, codes);
   if (res.empty()) return entry;
   return res[0].index;
 }
@@ -152,8 +313,10 @@ std::vector<std::size_t> Hnsw::select_neighbors_diverse(std::size_t base,
   std::vector<std::size_t> selected;
   selected.reserve(std::min(M, candidates.size()));
 
-  const float* base_ptr = store_.get_ptr(base);
-  if (!base_ptr) return selected;
+  if (!store_.is_alive(base)) return selected;
+
+  // Half rows are widened into c_buf; F32 rows are read in place.
+  std::vector<float> c_buf(store_.half_rows() ? store_.dim() : 0);
 
   for (const auto& cand : candidates) {
     if (selected.size() >= M) break;
@@ -161,17 +324,16 @@ std::vector<std::size_t> Hnsw::select_neighbors_diverse(std::size_t base,
     std::size_t c = cand.index;
     if (!store_.is_alive(c) || c == base) continue;
 
-    const float* c_ptr = store_.get_ptr(c);
-    if (!c_ptr) continue;
+    const float* c_ptr = store_.row_f32(c, c_buf.data());
+    const float c_inv = row_inv(c);
 
     float dc_base = cand.distance;
 
     bool ok = true;
     for (std::size_t s : selected) {
-      const float* s_ptr = store_.get_ptr(s);
-      if (!s_ptr) continue;
+      if (!store_.is_alive(s)) continue;
 
-      float dc_s = Distance::distance(metric_, c_ptr, s_ptr, store_.dim());
+      float dc_s = query_distance(c_ptr, c_inv, s);
       if (dc_s < dc_base) {
         ok = false;
         break;
@@ -194,25 +356,29 @@ std::vector<std::size_t> Hnsw::select_neighbors_diverse(std::size_t base,
   return selected;
 }
 
-void Hnsw::prune_neighbors(std::size_t node, int level) {
+void Hnsw::prune_neighbors(std::size_t node, int level, std::size_t extra) {
   int nl = node_level(node);
   if (nl < level) return;
 
-  auto& nbrs = graph_[node].links[level];
+  // A tombstone's list only routes; it is left as is.
+  if (!store_.is_alive(node)) return;
+
+  std::uint32_t* list = links(node, level);
   std::size_t M = max_deg(level);
-  if (nbrs.size() <= M) return;
 
-  const float* base = store_.get_ptr(node);
-  if (!base) return;
+  std::vector<float> base_buf(store_.half_rows() ? store_.dim() : 0);
+  const float* base = store_.row_f32(node, base_buf.data());
+  const float base_inv = row_inv(node);
 
   std::vector<SearchResult> cand;
-  cand.reserve(nbrs.size());
-  for (auto nb : nbrs) {
-    const float* v = store_.get_ptr(nb);
-    if (!v) continue;
-    float d = Distance::distance(metric_, base, v, store_.dim());
+  cand.reserve(list[0] + 1);
+  auto consider = [&](std::size_t nb) {
+    if (!store_.is_alive(nb)) return;
+    float d = query_distance(base, base_inv, nb);
     cand.push_back({nb, d});
-  }
+  };
+  for (std::uint32_t j = 1; j <= list[0]; ++j) consider(list[j]);
+  consider(extra);
 
   std::sort(cand.begin(), cand.end(),
             [](const SearchResult& a, const SearchResult& b) {
@@ -223,7 +389,7 @@ void Hnsw::prune_neighbors(std::size_t node, int level) {
       params_.use_diversity ? select_neighbors_diverse(node, cand, M)
                             : select_neighbors_simple(cand, M);
 
-  nbrs = std::move(kept);
+  set_links(list, kept);
 }
 
 void Hnsw::connect_bidirectional(std::size_t a, std::size_t b, int level) {
@@ -231,11 +397,25 @@ void Hnsw::connect_bidirectional(std::size_t a, std::size_t b, int level) {
   int lb = node_level(b);
   if (la < level || lb < level) return;
 
-  graph_[a].links[level].push_back(b);
-  graph_[b].links[level].push_back(a);
+  // Pruning a only reads a's list, so linking each side in turn matches
+  // linking both and then pruning both.
+  add_link(a, b, level);
+  add_link(b, a, level);
+}
 
-  prune_neighbors(a, level);
-  prune_neighbors(b, level);
+void Hnsw::add_link(std::size_t from, std::size_t to, int level) {
+  std::unique_lock<std::mutex> lock;
+  if (parallel_build_) lock = std::unique_lock<std::mutex>(link_lock(from));
+  std::uint32_t* list = links(from, level);
+  const std::uint32_t n = list[0];
+  // A re-linked node may already be on the list (see update()).
+  if (std::find(list + 1, list + 1 + n, static_cast<std::uint32_t>(to)) != list + 1 + n) return;
+  if (n < max_deg(level)) {
+    list[n + 1] = static_cast<std::uint32_t>(to);
+    list[0] = n + 1;
+    return;
+  }
+  prune_neighbors(from, level, to);
 }
 
 void Hnsw::insert(std::size_t index) {
@@ -243,8 +423,8 @@ void Hnsw::insert(std::size_t index) {
 
   ensure_node(index);
 
-  int lvl = random_level();
-  graph_[index].links.resize(static_cast<std::size_t>(lvl + 1));
+  int lvl = insert_level(index);
+  alloc_levels(index, lvl);
 
   if (!has_entry_) {
     entry_point_ = index;
@@ -253,16 +433,96 @@ void Hnsw::insert(std::size_t index) {
     return;
   }
 
-  const float* q = store_.get_ptr(index);
-  if (!q) return;
+  link_node(index, lvl);
+}
 
-  std::size_t ep = entry_point_;
-  for (int l = max_level_; l > lvl; --l) {
-    ep = greedy_descent(q, ep, l);
+void Hnsw::insert_batch(const std::vector<std::size_t>& indices) {
+  // Size the level-0 array once instead of growing it geometrically.
+  if (!indices.empty()) ensure_node(*std::max_element(indices.begin(), indices.end()));
+
+  std::size_t threads = params_.build_threads;
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  if (threads <= 1) {
+    for (std::size_t index : indices) insert(index);
+    return;
+  }
+
+  // Draw every level first, in order, from the same generator insert() uses,
+  // and allocate the level lists, so the link arrays are neither resized
+  // nor node_level() changed below.
+  std::vector<int> levels(indices.size(), -1);
+  for (std::size_t j = 0; j < indices.size(); ++j) {
+    const std::size_t index = indices[j];
+    if (!store_.is_alive(index)) continue;
+    ensure_node(index);
+    levels[j] = insert_level(index);
+    alloc_levels(index, levels[j]);
+  }
+
+  std::size_t first = 0;
+  if (!has_entry_) {
+    while (first < indices.size() && levels[first] < 0) ++first;
+    if (first == indices.size()) return;
+    entry_point_ = indices[first];
+    has_entry_ = true;
+    max_level_ = levels[first];
+    ++first;
   }
 
-  for (int l = std::min(lvl, max_level_); l >= 0; --l) {
-    auto candidates = search_level(q, ep, l, params_.ef_construction);
+  link_locks_ = std::make_unique<std::mutex[]>(kLinkLockStripes);
+  parallel_build_ = true;
+
+  std::atomic<std::size_t> next{first};
+  auto worker = [&]() {
+    for (std::size_t j = next++; j < indices.size(); j = next++) {
+      if (levels[j] >= 0) link_node(indices[j], levels[j]);
+    }
+  };
+
+  threads = std::min(threads, indices.size() - first);
+  std::vector<std::thread> pool;
+  pool.reserve(threads > 0 ? threads - 1 : 0);
+  for (std::size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+  worker();
+  for (auto& th : pool) th.join();
+
+  parallel_build_ = false;
+  link_locks_.reset();
+}
+
+void Hnsw::update(std::size_t index) {
+  if (!store_.is_alive(index)) return;
+  const int lvl = node_level(index);
+  if (lvl < 0) {
+    insert(index);
+    return;
+  }
+  link_node(index, lvl, /*relink=*/true);
+}
+
+void Hnsw::link_node(std::size_t index, int lvl, bool relink) {
+  std::size_t ep;
+  int max_level;
+  {
+    std::unique_lock<std::mutex> lock;
+    if (parallel_build_) lock = std::unique_lock<std::mutex>(entry_mtx_);
+    ep = entry_point_;
+    max_level = max_level_;
+  }
+
+  std::vector<float> q_buf(store_.half_rows() ? store_.dim() : 0);
+  const float* q = store_.row_f32(index, q_buf.data());
+  const float q_inv = row_inv(index);
+
+  ContextLease lease(*this);
+  SearchContext& ctx = lease.get();
+
+  for (int l = max_level; l > lvl; --l) {
+    ep = greedy_descent(ctx, q, q_inv, ep, l);
+  }
+
+  for (int l = std::min(lvl, max_level); l >= 0; --l) {
+    auto candidates = search_level(ctx, q, q_inv, ep, l, params_.ef_construction);
 
     candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
                                     [&](const SearchResult& r) { return r.index == index; }),
@@ -273,6 +533,10 @@ void Hnsw::insert(std::size_t index) {
         params_.use_diversity ? select_neighbors_diverse(index, candidates, M)
                               : select_neighbors_simple(candidates, M);
 
+    // The search above still ran over index's old edges on this level (it
+    // may be the entry point); only now are they replaced.
+    if (relink) links(index, l)[0] = 0;
+
     for (auto nb : chosen) {
       ensure_node(nb);
       if (node_level(nb) < l) continue;
@@ -282,13 +546,116 @@ void Hnsw::insert(std::size_t index) {
     if (!candidates.empty()) ep = candidates[0].index;
   }
 
-  if (lvl > max_level_) {
-    max_level_ = lvl;
-    entry_point_ = index;
+  if (lvl > max_level) {
+    std::unique_lock<std::mutex> lock;
+    if (parallel_build_) lock = std::unique_lock<std::mutex>(entry_mtx_);
+    if (lvl > max_level_) {
+      max_level_ = lvl;
+      entry_point_ = index;
+    }
+  }
+}
+
+bool Hnsw::repair_links(std::size_t node, int level) {
+  std::uint32_t* list = links(node, level);
+  if (std::all_of(list + 1, list + 1 + list[0],
+                  [&](std::size_t nb) { return store_.is_alive(nb); })) {
+    return false;
+  }
+
+  // One hop through each dead neighbor recovers the paths it carried.
+  std::vector<std::size_t> pool;
+  for (std::uint32_t j = 1; j <= list[0]; ++j) {
+    const std::size_t nb = list[j];
+    if (store_.is_alive(nb)) {
+      pool.push_back(nb);
+      continue;
+    }
+    if (node_level(nb) < level) continue;
+    const std::uint32_t* hop = links(nb, level);
+    for (std::uint32_t h = 1; h <= hop[0]; ++h) {
+      const std::size_t x = hop[h];
+      if (x != node && store_.is_alive(x) && node_level(x) >= level) pool.push_back(x);
+    }
+  }
+  std::sort(pool.begin(), pool.end());
+  pool.erase(std::unique(pool.begin(), pool.end()), pool.end());
+
+  std::vector<float> base_buf(store_.half_rows() ? store_.dim() : 0);
+  const float* base = store_.row_f32(node, base_buf.data());
+  const float base_inv = row_inv(node);
+
+  std::vector<SearchResult> cand;
+  cand.reserve(pool.size());
+  for (std::size_t x : pool) cand.push_back({x, query_distance(base, base_inv, x)});
+  std::sort(cand.begin(), cand.end(),
+            [](const SearchResult& a, const SearchResult& b) {
+              return a.distance < b.distance;
+            });
+
+  const std::size_t M = max_deg(level);
+  set_links(list, params_.use_diversity ? select_neighbors_diverse(node, cand, M)
+                                        : select_neighbors_simple(cand, M));
+  return true;
+}
+
+void Hnsw::reassign_entry() {
+  // Usually a live neighbor on the top level is enough.
+  if (node_level(entry_point_) >= max_level_ && max_level_ >= 0) {
+    const std::uint32_t* list = links(entry_point_, max_level_);
+    for (std::uint32_t j = 1; j <= list[0]; ++j) {
+      const std::size_t nb = list[j];
+      if (store_.is_alive(nb) && node_level(nb) >= max_level_) {
+        entry_point_ = nb;
+        return;
+      }
+    }
+  }
+
+  has_entry_ = false;
+  max_level_ = -1;
+  for (std::size_t i = 0; i < levels_.size(); ++i) {
+    const int lvl = node_level(i);
+    if (lvl > max_level_ && store_.is_alive(i)) {
+      entry_point_ = i;
+      max_level_ = lvl;
+      has_entry_ = true;
+    }
   }
 }
 
-std::vector<SearchResult> Hnsw::search(const std::vector<float>& query,
+void Hnsw::remove(std::size_t index) {
+  if (store_.is_alive(index)) return;
+  const int lvl = node_level(index);
+  if (lvl < 0) return;
+
+  for (int l = lvl; l >= 0; --l) {
+    const std::uint32_t* list = links(index, l);
+    for (std::uint32_t j = 1; j <= list[0]; ++j) {
+      const std::size_t nb = list[j];
+      if (store_.is_alive(nb) && node_level(nb) >= l) repair_links(nb, l);
+    }
+  }
+  if (has_entry_ && entry_point_ == index) reassign_entry();
+}
+
+std::size_t Hnsw::repair_tombstones() {
+  std::size_t repaired = 0;
+  for (std::size_t i = 0; i < levels_.size(); ++i) {
+    if (!store_.is_alive(i)) continue;
+    for (int l = node_level(i); l >= 0; --l) {
+      if (repair_links(i, l)) ++repaired;
+    }
+  }
+  // Only now: the repairs above read dead nodes' lists.
+  for (std::size_t i = 0; i < levels_.size(); ++i) {
+    if (!store_.is_alive(i)) levels_[i] = -1;
+  }
+  if (has_entry_ && !store_.is_alive(entry_point_)) reassign_entry();
+  return repaired;
+}
+
+std::vector<SearchResult> Hnsw::search(VectorView query,
                                       std::size_t k,
                                       std::size_t ef_search) const {
   if (!has_entry_ || k == 0) return {};
@@ -296,15 +663,87 @@ std::vector<SearchResult> Hnsw::search(const std::vector<float>& query,
     throw std::invalid_argument("Hnsw::search: query dim mismatch");
   }
 
-  const float* q = query.data();
+  AlignedVector<float> q_buf;
+  const float* q = store_.aligned_query(query.data(), q_buf);
+  // Query norm is computed once here instead of once per visited node.
+  const float q_inv = uses_norms_ ? Distance::inv_norm(q, store_.dim()) : 1.0f;
+
+  ContextLease lease(*this);
+  SearchContext& ctx = lease.get();
 
   std::size_t ep = entry_point_;
   for (int l = max_level_; l > 0; --l) {
-    ep = greedy_descent(q, ep, l);
+    ep = greedy_descent(ctx, q, q_inv, ep, l);
   }
 
   std::size_t ef = std::max<std::size_t>(ef_search, k);
-  auto res = search_level(q, ep, /*level=*/0, ef);
+  auto res = search_level(ctx, q, q_inv, ep, /*level=*/0, ef);
+  if (res.size() > k) res.resize(k);
+  return res;
+}
+
+std::vector<SearchResult> Hnsw::search_quantized(VectorView query,
+                                                std::size_t k,
+                                                std::size_t ef_search) const {
+  if (!store_.has_sq8()) return search(query, k, ef_search);
+  if (!has_entry_ || k == 0) return {};
+  if (query.size() != store_.dim()) {
+    throw std::invalid_argument("Hnsw::search_quantized: query dim mismatch");
+  }
+
+  AlignedVector<float> q_buf;
+  const float* q = store_.aligned_query(query.data(), q_buf);
+  const float q_inv = uses_norms_ ? Distance::inv_norm(q, store_.dim()) : 1.0f;
+  const ScalarQuantizer::Query sq8 = store_.sq8().prepare(metric_, q, q_inv);
+
+  CodeQuery codes;
+  codes.sq8 = &sq8;
+  ContextLease lease(*this);
+  return search_codes(lease.get(), q, q_inv, k, ef_search, codes);
+}
+
+std::vector<SearchResult> Hnsw::search_pq(VectorView query,
+                                         std::size_t k,
+                                         std::size_t ef_search) const {
+  if (!store_.has_pq()) return search(query, k, ef_search);
+  if (!has_entry_ || k == 0) return {};
+  if (query.size() != store_.dim()) {
+    throw std::invalid_argument("Hnsw::search_pq: query dim mismatch");
+  }
+
+  AlignedVector<float> q_buf;
+  const float* q = store_.aligned_query(query.data(), q_buf);
+  const float q_inv = uses_norms_ ? Distance::inv_norm(q, store_.dim()) : 1.0f;
+  const ProductQuantizer::Table table = store_.pq().prepare(metric_, q, q_inv);
+
+  CodeQuery codes;
+  codes.pq = &table;
+  ContextLease lease(*this);
+  return search_codes(lease.get(), q, q_inv, k, ef_search, codes);
+}
+
+std::vector<SearchResult> Hnsw::search_codes(SearchContext& ctx,
+                                            const float* q,
+                                            float q_inv,
+                                            std::size_t k,
+                                            std::size_t ef_search,
+                                            const CodeQuery& codes) const {
+  std::size_t ep = entry_point_;
+  for (int l = max_level_; l > 0; --l) {
+    ep = greedy_descent(ctx, q, q_inv, ep, l, &codes);
+  }
+
+  std::size_t ef = std::max<std::size_t>(ef_search, k);
+  auto res = search_level(ctx, q, q_inv, ep, /*level=*/0, ef, &codes);
+
+  // Rerank: only the ef survivors touch the float rows.
+  for (auto& r : res) {
+    r.distance = query_distance(q, q_inv, r.index);
+  }
+  std::sort(res.begin(), res.end(),
+            [](const SearchResult& a, const SearchResult& b) {
+              return a.distance < b.distance;
+            });
   if (res.size() > k) res.resize(k);
   return res;
 }
@@ -321,16 +760,16 @@ Hnsw::Export Hnsw::export_graph() const {
   const std::size_t N = store_.size();
   ex.nodes.resize(N);
 
-  // graph_ may be smaller if no nodes inserted; resize logic is safe.
+  // levels_ may be shorter if the last slots were never inserted.
   for (std::size_t i = 0; i < N; ++i) {
-    if (i >= graph_.size() || graph_[i].links.empty()) {
-      ex.nodes[i].level = -1;
-      ex.nodes[i].links.clear();
-      continue;
-    }
-    int lvl = static_cast<int>(graph_[i].links.size()) - 1;
+    int lvl = node_level(i);
     ex.nodes[i].level = lvl;
-    ex.nodes[i].links = graph_[i].links;  // deep copy
+    if (lvl < 0) continue;
+    ex.nodes[i].links.resize(static_cast<std::size_t>(lvl + 1));
+    for (int l = 0; l <= lvl; ++l) {
+      const std::uint32_t* list = links(i, l);
+      ex.nodes[i].links[static_cast<std::size_t>(l)].assign(list + 1, list + 1 + list[0]);
+    }
   }
   return ex;
 }
@@ -347,20 +786,39 @@ void Hnsw::import_graph(const Export& ex) {
     throw std::runtime_error("Hnsw::import_graph: node count mismatch vs store.size()");
   }
 
-  graph_.clear();
-  graph_.resize(N);
+  levels_.clear();
+  sized_levels_.clear();
+  upper_run_.clear();
+  level0_.clear();
+  upper_.clear();
+  if (N > 0) ensure_node(N - 1);
+
+  std::size_t upper_runs = 0;
+  for (const auto& n : ex.nodes) upper_runs += static_cast<std::size_t>(std::max(n.level, 0));
+  upper_.reserve(upper_runs * upper_stride_);
 
   for (std::size_t i = 0; i < N; ++i) {
     const auto& n = ex.nodes[i];
-    if (n.level < 0) {
-      graph_[i].links.clear();
-      continue;
-    }
-    // Basic validation: links size should be level+1
-    if (n.links.size() != static_cast<std::size_t>(n.level + 1)) {
+    if (n.level < 0) continue;
+    // Basic validation: links size should be level+1, and every list must
+    // fit its fixed-capacity run.
+    if (n.level > std::numeric_limits<std::int8_t>::max() ||
+        n.links.size() != static_cast<std::size_t>(n.level + 1)) {
       throw std::runtime_error("Hnsw::import_graph: links size mismatch at node " + std::to_string(i));
     }
-    graph_[i].links = n.links;
+    alloc_levels(i, n.level);
+    for (int l = 0; l <= n.level; ++l) {
+      const auto& nbrs = n.links[static_cast<std::size_t>(l)];
+      if (nbrs.size() > max_deg(l)) {
+        throw std::runtime_error("Hnsw::import_graph: degree above M/M0 at node " + std::to_string(i));
+      }
+      for (std::size_t nb : nbrs) {
+        if (nb >= N) {
+          throw std::runtime_error("Hnsw::import_graph: neighbor out of range at node " + std::to_string(i));
+        }
+      }
+      set_links(links(i, l), nbrs);
+    }
   }
 
   // After import, we should consider RNG state uninitialized.
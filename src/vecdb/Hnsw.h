@@ -1,16 +1,24 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "Distance.h"
 #include "SearchResult.h"
 #include "VectorStore.h"
-#include "Visited.h"
+#include "VectorView.h"
 
 namespace vecdb {
 
+// Hierarchical navigable small world graph over a VectorStore's slots.
+// Searches (search, search_quantized, search_pq) are const and may run
+// concurrently with each other: each one checks out its own scratch context.
+// Mutations (insert, insert_batch, update, remove, repair_tombstones,
+// import_graph) need exclusive access; insert_batch() parallelizes
+// internally.
 class Hnsw {
  public:
   struct Params {
@@ -20,6 +28,10 @@ class Hnsw {
     bool use_diversity = true;
     unsigned seed = 123;
     float level_mult = 1.0f;
+    // Threads used by insert_batch(): 1 links nodes one at a time (the graph
+    // is then a pure function of seed and insert order), 0 uses
+    // std::thread::hardware_concurrency(). Not persisted.
+    std::size_t build_threads = 1;
   };
 
   // -------- Persistence export/import (v1) --------
@@ -39,45 +51,173 @@ class Hnsw {
   };
 
   Hnsw(const VectorStore& store, Metric metric)
-      : store_(store), metric_(metric), params_() {}
+      : Hnsw(store, metric, Params{}) {}
 
-  Hnsw(const VectorStore& store, Metric metric, Params params)
-      : store_(store), metric_(metric), params_(params) {}
+  Hnsw(const VectorStore& store, Metric metric, Params params);
 
-  // Insert a node (by store index) into the graph.
+  ~Hnsw();
+
+  // Insert a node (by store index) into the graph. Neighbor ids are stored
+  // as 32 bits, so index must be below 2^32 - 1 (throws std::length_error).
   void insert(std::size_t index);
 
+  // Re-links a node whose row changed (or that was revived): its neighbors
+  // on every level are chosen again against the current graph and its old
+  // out-edges replaced; edges pointing at it are kept, and old neighbors
+  // that are chosen again are not duplicated. Inserts the node if it is not
+  // in the graph yet. Dead slots stay in the graph as tombstones that
+  // searches route through but never return (see remove()).
+  void update(std::size_t index);
+
+  // Called after a slot was removed from the store. Repairs the node's
+  // neighbors right away: each one whose list points at the dead node picks
+  // its neighbors again (select_neighbors_diverse) from its live neighbors
+  // plus the dead node's live neighbors, so paths through it stay open. The
+  // dead node keeps its own out-edges for routing any in-edges not repaired
+  // here, and the entry point moves to a live node if it was this one.
+  void remove(std::size_t index);
+
+  // Batch pass over the whole graph: every live node whose lists point at a
+  // dead slot is repaired as in remove(), then dead nodes are unlinked
+  // entirely (a later update() re-inserts them if revived). Returns the
+  // number of neighbor lists rewritten. Meant to run periodically, e.g.
+  // once many slots have been removed.
+  std::size_t repair_tombstones();
+
+  // Inserts the given slots (dead ones are skipped) on params.build_threads
+  // threads. Levels are drawn up front in order, so every node gets the
+  // level a serial build would give it; threads then link nodes
+  // concurrently, guarding neighbor lists with striped locks and the entry
+  // point / max level with a mutex. Only the interleaving, and so the exact
+  // edges, varies between parallel runs.
+  void insert_batch(const std::vector<std::size_t>& indices);
+
   // Search for k nearest neighbors (approx) with ef_search.
-  std::vector<SearchResult> search(const std::vector<float>& query,
+  std::vector<SearchResult> search(VectorView query,
                                    std::size_t k,
                                    std::size_t ef_search) const;
 
+  // Same, but the graph is traversed on the store's SQ8 codes (see
+  // VectorStore::enable_sq8()), reading dim bytes per visited node instead of
+  // 4*dim. The ef best candidates are then reranked with exact float
+  // distances. Falls back to search() when the store has no codes.
+  std::vector<SearchResult> search_quantized(VectorView query,
+                                             std::size_t k,
+                                             std::size_t ef_search) const;
+
+  // Same as search_quantized(), but nodes are scored with the store's PQ
+  // codes (see VectorStore::enable_pq()): one m x 256 table per query, then
+  // m lookups per visited node. Falls back to search() without PQ codes.
+  std::vector<SearchResult> search_pq(VectorView query,
+                                      std::size_t k,
+                                      std::size_t ef_search) const;
+
   bool empty() const { return !has_entry_; }
+  Metric metric() const { return metric_; }
   int max_level() const { return max_level_; }
 
+  // 32-bit words held by the adjacency arrays (level 0 plus the upper pool).
+  std::size_t link_words() const { return level0_.size() + upper_.size(); }
+
   // Export / import the internal graph structure for persistence.
   Export export_graph() const;
   void import_graph(const Export& ex);
 
  private:
-  struct NodeLinks {
-    std::vector<std::vector<std::size_t>> links;  // links[level] -> neighbor indices
+
+  // Scratch for one traversal: visited stamps, heap storage and neighbor
+  // batch buffers (defined in Hnsw.cpp). A context is used by one search at
+  // a time and reused by later ones, so steady-state searches allocate only
+  // their result vector.
+  struct SearchContext;
+
+  // RAII checkout of a SearchContext from ctx_pool_; returns it on scope exit.
+  class ContextLease;
+
+  // Exact distance from a float vector (a query laid out by
+  // VectorStore::aligned_query(), or a stored row read with
+  // VectorStore::row_f32()) to a stored row, whatever the store's row format.
+  float query_distance(const float* q, float q_inv, std::size_t index) const {
+    if (half_dist_) {
+      return half_dist_(q, store_.half_row_ptr(index), store_.dim(), q_inv, row_inv(index));
+    }
+    return dist_(q, store_.row_ptr(index), store_.row_stride(), q_inv, row_inv(index));
+  }
+
+  // Prepared query for scoring nodes on compressed codes instead of float
+  // rows; exactly one member is set.
+  struct CodeQuery {
+    const ScalarQuantizer::Query* sq8 = nullptr;
+    const ProductQuantizer::Table* pq = nullptr;
   };
 
+  float code_distance(const CodeQuery& cq, std::size_t index) const {
+    if (cq.pq) return store_.pq().distance(*cq.pq, store_.pq_code(index), row_inv(index));
+    return store_.sq8().distance(*cq.sq8, store_.sq8_code(index), row_inv(index));
+  }
+
+  // Inverse norm of a stored row; only loaded when the metric reads it.
+  float row_inv(std::size_t index) const { return uses_norms_ ? store_.inv_norm(index) : 1.0f; }
+
   int random_level();
+
+  // Level for a node about to be inserted: the level its runs were sized for
+  // if it held any (it was unlinked by repair_tombstones() and is now being
+  // revived), so alloc_levels() reuses them; otherwise a fresh draw.
+  int insert_level(std::size_t index);
   std::size_t max_deg(int level) const { return (level == 0) ? params_.M0 : params_.M; }
 
   void ensure_node(std::size_t index);
-  int node_level(std::size_t index) const;
+  int node_level(std::size_t index) const {
+    return index < levels_.size() ? levels_[index] : -1;
+  }
+
+  // Gives node index level lvl with empty lists. Its own runs are reused if
+  // they were sized for at least lvl levels; otherwise lvl fresh runs are
+  // appended to upper_ (the old ones go once the graph is rebuilt or
+  // imported).
+  void alloc_levels(std::size_t index, int lvl);
+
+  // Neighbor list of index on level (precondition: level <= node_level):
+  // word 0 is the count, words 1..count the neighbor slots, and the run has
+  // room for max_deg(level) of them.
+  std::uint32_t* links(std::size_t index, int level) {
+    if (level == 0) return level0_.data() + index * level0_stride_;
+    return upper_.data() + (upper_run_[index] + static_cast<std::size_t>(level) - 1) * upper_stride_;
+  }
+  const std::uint32_t* links(std::size_t index, int level) const {
+    if (level == 0) return level0_.data() + index * level0_stride_;
+    return upper_.data() + (upper_run_[index] + static_cast<std::size_t>(level) - 1) * upper_stride_;
+  }
 
-  std::vector<SearchResult> search_level(const float* query_ptr,
+  // Overwrites a list with ids (at most max_deg of its level).
+  static void set_links(std::uint32_t* list, const std::vector<std::size_t>& ids);
+
+  // query_inv is 1/||query||, computed once per search (only COSINE reads it).
+  // With codes set, nodes are scored on the store's SQ8/PQ codes instead of
+  // the float rows (see search_quantized()).
+  std::vector<SearchResult> search_level(SearchContext& ctx,
+                                        const float* query_ptr,
+                                        float query_inv,
                                         std::size_t entry,
                                         int level,
-                                        std::size_t ef) const;
+                                        std::size_t ef,
+                                        const CodeQuery* codes = nullptr) const;
 
-  std::size_t greedy_descent(const float* query_ptr,
+  std::size_t greedy_descent(SearchContext& ctx,
+                             const float* query_ptr,
+                             float query_inv,
                              std::size_t entry,
-                             int level) const;
+                             int level,
+                             const CodeQuery* codes = nullptr) const;
+
+  // Traverses on codes, then reranks the ef survivors with exact distances.
+  std::vector<SearchResult> search_codes(SearchContext& ctx,
+                                         const float* query_ptr,
+                                         float query_inv,
+                                         std::size_t k,
+                                         std::size_t ef_search,
+                                         const CodeQuery& codes) const;
 
   std::vector<std::size_t> select_neighbors_simple(const std::vector<SearchResult>& candidates,
                                                    std::size_t M) const;
@@ -86,14 +226,69 @@ class Hnsw {
                                                     const std::vector<SearchResult>& candidates,
                                                     std::size_t M) const;
 
-  void prune_neighbors(std::size_t node, int level);
+  // insert() after the node's level lists are allocated: descends from the
+  // entry point, links the node on levels min(lvl, max_level)..0 and raises
+  // the entry point if lvl is a new maximum. With relink (update()), each
+  // level's old out-edges are dropped once its new neighbors are chosen.
+  void link_node(std::size_t index, int lvl, bool relink = false);
+
+  // Rewrites node's list on level if it holds dead slots: candidates are its
+  // live neighbors plus the live neighbors of its dead ones. Returns whether
+  // the list changed.
+  bool repair_links(std::size_t node, int level);
+
+  // Points entry_point_ / max_level_ at a live node on the highest level
+  // (clears has_entry_ if there is none).
+  void reassign_entry();
+
+  // Called when node's list on level is full: picks max_deg(level) neighbors
+  // from the list plus extra.
+  void prune_neighbors(std::size_t node, int level, std::size_t extra);
   void connect_bidirectional(std::size_t a, std::size_t b, int level);
 
+  // Appends to (and if full prunes) one neighbor list, under its link lock
+  // during a parallel build.
+  void add_link(std::size_t from, std::size_t to, int level);
+
+  // Lock guarding index's neighbor lists while parallel_build_.
+  // Striped rather than per node to bound memory; a thread never holds two,
+  // so stripes shared by two nodes cannot deadlock.
+  static constexpr std::size_t kLinkLockStripes = std::size_t{1} << 14;
+  std::mutex& link_lock(std::size_t index) const {
+    return link_locks_[index & (kLinkLockStripes - 1)];
+  }
+
   const VectorStore& store_;
   Metric metric_;
   Params params_;
 
-  std::vector<NodeLinks> graph_;
+  // Metric and dim-specialized kernel resolved once at construction (aligned
+  // variants over row_stride() for padded stores); hot
+  // loops call it directly.
+  DistanceFn dist_;
+  BatchDistanceFn batch_dist_;  // scores a node's neighbor list in one call
+  BoundedBatchDistanceFn bounded_dist_;  // early-abandon kernel once ef is full (L2 only)
+  HalfDistanceFn half_dist_;  // set iff the store keeps F16 / BF16 rows; replaces the above
+  bool uses_norms_;
+
+  // Adjacency as fixed-stride runs of 32-bit words (see links()), with no
+  // allocation per node or per list:
+  // - level0_: every node's level-0 list, M0 + 1 words apart, so a hop at
+  //   the level searches spend most time on is one offset computation.
+  // - upper_: the rarer upper levels; a node with level L > 0 owns L
+  //   consecutive runs of M + 1 words starting at run upper_run_[index].
+  // - levels_: each node's level, -1 when it is not in the graph.
+  // - sized_levels_: the level a node's runs were sized for, -1 if it never
+  //   had any. Kept when the node is unlinked, so a revived slot links back
+  //   into the same storage and remove / repair / re-upsert churn does not
+  //   grow upper_.
+  std::size_t level0_stride_;
+  std::size_t upper_stride_;
+  std::vector<std::uint32_t> level0_;
+  std::vector<std::uint32_t> upper_;
+  std::vector<std::uint32_t> upper_run_;
+  std::vector<std::int8_t> levels_;
+  std::vector<std::int8_t> sized_levels_;
 
   std::size_t entry_point_ = 0;
   bool has_entry_ = false;
@@ -102,8 +297,19 @@ class Hnsw {
   mutable bool rng_inited_ = false;
   mutable unsigned rng_state_ = 0;
 
-  // Reusable visited buffer (stamp-array) for searches.
-  mutable Visited visited_;
+  // Set only while insert_batch() links nodes on several threads. Traversals
+  // then read neighbor lists under link_lock(), and entry_point_ / max_level_
+  // are read and raised together under entry_mtx_. Serial inserts and
+  // searches skip both.
+  bool parallel_build_ = false;
+  std::unique_ptr<std::mutex[]> link_locks_;
+  std::mutex entry_mtx_;
+
+  // Idle search contexts. A search pops one (or creates one if none is
+  // idle) and pushes it back when done, so the pool grows to the peak number
+  // of concurrent searches and the lock is held only for the pop / push.
+  mutable std::mutex ctx_mtx_;
+  mutable std::vector<std::unique_ptr<SearchContext>> ctx_pool_;
 };
 
 }  // namespace vecdb
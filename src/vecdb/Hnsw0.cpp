@@ -25,6 +25,7 @@ struct ResMaxHeap {
 }  // namespace
 
 std::vector<SearchResult> Hnsw0::search_layer0(const float* query_ptr,
+                                              float query_inv,
                                               std::size_t entry,
                                               std::size_t ef_search) const {
   if (!has_entry_ || ef_search == 0) return {};
@@ -33,7 +34,7 @@ std::vector<SearchResult> Hnsw0::search_layer0(const float* query_ptr,
   auto dist_to = [&](std::size_t idx) -> float {
     const float* v = store_.get_ptr(idx);
     if (!v) return std::numeric_limits<float>::infinity();
-    return Distance::distance(metric_, query_ptr, v, store_.dim());
+    return dist_(query_ptr, v, store_.dim(), query_inv, row_inv(idx));
   };
 
   // --- visited: stamp-array ---
@@ -122,7 +123,7 @@ std::vector<std::size_t> Hnsw0::select_neighbors_diverse(std::size_t base,
       const float* s_ptr = store_.get_ptr(s);
       if (!s_ptr) continue;
 
-      float dc_s = Distance::distance(metric_, c_ptr, s_ptr, store_.dim());
+      float dc_s = row_distance(c, c_ptr, s, s_ptr);
       if (dc_s < dc_base) {
         ok = false;
         break;
@@ -157,7 +158,7 @@ void Hnsw0::prune_neighbors(std::size_t node) {
   for (auto nb : nbrs) {
     const float* v = store_.get_ptr(nb);
     if (!v) continue;
-    float d = Distance::distance(metric_, base, v, store_.dim());
+    float d = row_distance(node, base, nb, v);
     cand.push_back({nb, d});
   }
 
@@ -194,7 +195,7 @@ void Hnsw0::insert(std::size_t index) {
   const float* q = store_.get_ptr(index);
   if (!q) return;
 
-  auto candidates = search_layer0(q, entry_point_, params_.ef_construction);
+  auto candidates = search_layer0(q, row_inv(index), entry_point_, params_.ef_construction);
 
   candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
                                   [&](const SearchResult& r) { return r.index == index; }),
@@ -219,7 +220,8 @@ std::vector<SearchResult> Hnsw0::search(const std::vector<float>& query,
   }
 
   std::size_t ef = std::max(ef_search, k);
-  auto candidates = search_layer0(query.data(), entry_point_, ef);
+  const float q_inv = uses_norms_ ? Distance::inv_norm(query.data(), store_.dim()) : 1.0f;
+  auto candidates = search_layer0(query.data(), q_inv, entry_point_, ef);
   if (candidates.size() > k) candidates.resize(k);
   return candidates;
 }
@@ -19,10 +19,14 @@ class Hnsw0 {
   };
 
   Hnsw0(const VectorStore& store, Metric metric)
-      : store_(store), metric_(metric), params_() {}
+      : Hnsw0(store, metric, Params{}) {}
 
   Hnsw0(const VectorStore& store, Metric metric, Params params)
-      : store_(store), metric_(metric), params_(params) {}
+      : store_(store),
+        metric_(metric),
+        params_(params),
+        dist_(Distance::resolve(metric, store.dim())),
+        uses_norms_(metric == Metric::COSINE) {}
 
   void insert(std::size_t index);
 
@@ -31,10 +35,18 @@ class Hnsw0 {
                                    std::size_t ef_search) const;
 
   bool empty() const { return !has_entry_; }
+  Metric metric() const { return metric_; }
   std::size_t size() const { return neighbors_.size(); }
 
  private:
+  float row_distance(std::size_t a, const float* a_ptr, std::size_t b, const float* b_ptr) const {
+    return dist_(a_ptr, b_ptr, store_.dim(), row_inv(a), row_inv(b));
+  }
+  float row_inv(std::size_t index) const { return uses_norms_ ? store_.inv_norm(index) : 1.0f; }
+
+  // query_inv is 1/||query||, computed once per search (only COSINE reads it).
   std::vector<SearchResult> search_layer0(const float* query_ptr,
+                                         float query_inv,
                                          std::size_t entry,
                                          std::size_t ef_search) const;
 
@@ -52,6 +64,10 @@ class Hnsw0 {
   Metric metric_;
   Params params_;
 
+  // Metric and dim-specialized kernel resolved once at construction.
+  DistanceFn dist_;
+  bool uses_norms_;
+
   std::vector<std::vector<std::size_t>> neighbors_;
 
   std::size_t entry_point_ = 0;
@@ -0,0 +1,102 @@
+#include "IdIndex.h"
+
+#include <functional>
+
+#include "ReserveGeometric.h"
+
+namespace vecdb {
+
+std::uint64_t IdIndex::hash_(std::string_view id) {
+  // std::hash quality varies by library (and is 32-bit on some targets);
+  // the murmur3 finalizer spreads it over the low bits the probe uses.
+  std::uint64_t h = std::hash<std::string_view>{}(id);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+std::size_t IdIndex::capacity_for_(std::size_t n) {
+  std::size_t cap = 16;
+  while (n > cap / 4 * 3) cap *= 2;
+  return cap;
+}
+
+std::size_t IdIndex::find(std::string_view id) const {
+  if (table_.empty()) return npos;
+  const std::uint64_t h = hash_(id);
+  const std::size_t mask = table_.size() - 1;
+  for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+    const Entry& e = table_[i];
+    if (e.slot == kEmpty) return npos;
+    if (e.hash == h && this->id(e.slot) == id) return e.slot;
+  }
+}
+
+void IdIndex::map_(std::string_view id, std::uint64_t h, std::size_t slot) {
+  if (mapped_ + 1 > table_.size() / 4 * 3) rehash_(capacity_for_(mapped_ + 1));
+  const std::size_t mask = table_.size() - 1;
+  for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+    Entry& e = table_[i];
+    if (e.slot == kEmpty) {
+      e = Entry{h, slot};
+      ++mapped_;
+      return;
+    }
+    if (e.hash == h && this->id(e.slot) == id) {
+      e.slot = slot;
+      return;
+    }
+  }
+}
+
+void IdIndex::rehash_(std::size_t cap) {
+  std::vector<Entry> old(cap, Entry{0, kEmpty});
+  old.swap(table_);
+  const std::size_t mask = cap - 1;
+  for (const Entry& e : old) {
+    if (e.slot == kEmpty) continue;
+    std::size_t i = e.hash & mask;
+    while (table_[i].slot != kEmpty) i = (i + 1) & mask;
+    table_[i] = e;
+  }
+}
+
+void IdIndex::append(std::string_view id) {
+  const std::size_t slot = size();
+  arena_.insert(arena_.end(), id.begin(), id.end());
+  offsets_.push_back(arena_.size());
+  if (!id.empty()) map_(id, hash_(id), slot);
+}
+
+void IdIndex::assign(const std::vector<std::string>& ids) {
+  clear();
+  std::size_t bytes = 0;
+  std::size_t named = 0;
+  for (const auto& id : ids) {
+    bytes += id.size();
+    if (!id.empty()) ++named;
+  }
+  arena_.reserve(bytes);
+  offsets_.reserve(ids.size() + 1);
+  rehash_(capacity_for_(named));
+  for (const auto& id : ids) append(id);
+}
+
+void IdIndex::reserve(std::size_t n) {
+  reserve_geometric(offsets_, n + 1);
+  const std::size_t cap = capacity_for_(n);
+  if (cap > table_.size()) rehash_(cap);
+  if (size() > 0) reserve_geometric(arena_, n * (arena_.size() / size()));
+}
+
+void IdIndex::clear() {
+  arena_.clear();
+  offsets_.assign(1, 0);
+  table_.clear();
+  mapped_ = 0;
+}
+
+}  // namespace vecdb
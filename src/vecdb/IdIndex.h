@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vecdb {
+
+// Slot -> id and id -> slot for VectorStore, without a heap object per id.
+// - Ids live back to back in one char arena; slot i is the byte range
+//   [offsets_[i], offsets_[i + 1]). A slot's id never changes once appended.
+// - Lookup is an open-addressing (linear probing) table of {hash, slot}
+//   pairs. The stored hash rejects almost every mismatch without touching
+//   the arena, and rehashing never re-reads the strings.
+// Per id this costs the id bytes + 8 (offset) + 16..32 (table), versus a
+// std::string plus an unordered_map node holding a second copy.
+//
+// Entries are never erased individually (VectorStore keeps dead ids mapped
+// so they can be revived); clear() drops everything.
+class IdIndex {
+ public:
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  // Number of slots (including ones with an empty id).
+  std::size_t size() const { return offsets_.size() - 1; }
+
+  // Id of a slot. The view points into the arena, so it is invalidated by
+  // the next append() / assign() / clear(). Precondition: slot < size().
+  std::string_view id(std::size_t slot) const {
+    return std::string_view(arena_.data() + offsets_[slot],
+                            static_cast<std::size_t>(offsets_[slot + 1] - offsets_[slot]));
+  }
+
+  // Slot mapped to id, or npos.
+  std::size_t find(std::string_view id) const;
+
+  // Appends slot size() named id. A non-empty id is mapped to the new slot,
+  // replacing any earlier slot with the same id; an empty id stays unmapped.
+  void append(std::string_view id);
+
+  // Replaces the contents with ids (slot i named ids[i]), sizing the arena
+  // and table once. Later duplicates win, as with append().
+  void assign(const std::vector<std::string>& ids);
+
+  // Pre-allocates offsets and table room for n slots, and arena room at the
+  // current average id length.
+  void reserve(std::size_t n);
+
+  void clear();
+
+ private:
+  struct Entry {
+    std::uint64_t hash;
+    std::uint64_t slot;  // kEmpty when unused
+  };
+  static constexpr std::uint64_t kEmpty = ~std::uint64_t{0};
+
+  static std::uint64_t hash_(std::string_view id);
+
+  // Maps id (hash h) to slot, overwriting an existing entry for the same id.
+  void map_(std::string_view id, std::uint64_t h, std::size_t slot);
+
+  // Resizes the table to cap entries (a power of two) and reinserts.
+  void rehash_(std::size_t cap);
+
+  // Table capacity keeping n entries under the 3/4 load limit.
+  static std::size_t capacity_for_(std::size_t n);
+
+  std::vector<char> arena_;
+  std::vector<std::uint64_t> offsets_{0};
+  std::vector<Entry> table_;
+  std::size_t mapped_ = 0;
+};
+
+}  // namespace vecdb
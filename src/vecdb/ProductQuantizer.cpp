@@ -0,0 +1,174 @@
+#include "ProductQuantizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace vecdb {
+
+ProductQuantizer::ProductQuantizer(std::size_t dim, std::size_t m) : dim_(dim), m_(m) {
+  if (m_ == 0 || m_ > dim_ || dim_ % m_ != 0) {
+    throw std::invalid_argument("ProductQuantizer: subspaces must divide dim");
+  }
+  dsub_ = dim_ / m_;
+}
+
+std::uint8_t ProductQuantizer::nearest(std::size_t sub, const float* x) const {
+  std::size_t best = 0;
+  float best_d = std::numeric_limits<float>::infinity();
+  for (std::size_t c = 0; c < kCentroids; ++c) {
+    const float* cc = centroid(sub, c);
+    float d = 0.0f;
+    for (std::size_t t = 0; t < dsub_; ++t) {
+      const float diff = x[t] - cc[t];
+      d += diff * diff;
+    }
+    if (d < best_d) {
+      best_d = d;
+      best = c;
+    }
+  }
+  return static_cast<std::uint8_t>(best);
+}
+
+void ProductQuantizer::train(const float* const* rows, std::size_t n,
+                             std::size_t iters, unsigned seed) {
+  if (dim_ == 0) throw std::logic_error("ProductQuantizer::train: dim is 0");
+
+  std::mt19937 rng(seed);
+
+  // Shuffled sample: the first 256 entries double as the initial centroids.
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::shuffle(order.begin(), order.end(), rng);
+  order.resize(std::min(n, kCentroids * kMaxPointsPerCentroid));
+  const std::size_t ns = order.size();
+
+  centroids_.assign(m_ * kCentroids * dsub_, 0.0f);
+  trained_ = true;
+  if (ns == 0) return;
+
+  std::vector<float> sub(ns * dsub_);
+  std::vector<std::uint8_t> assign(ns, 0);
+  std::vector<float> sums(kCentroids * dsub_);
+  std::vector<std::size_t> counts(kCentroids);
+  std::uniform_int_distribution<std::size_t> pick(0, ns - 1);
+
+  for (std::size_t j = 0; j < m_; ++j) {
+    for (std::size_t i = 0; i < ns; ++i) {
+      const float* src = rows[order[i]] + j * dsub_;
+      std::copy(src, src + dsub_, sub.data() + i * dsub_);
+    }
+
+    float* cb = centroids_.data() + j * kCentroids * dsub_;
+    for (std::size_t c = 0; c < kCentroids; ++c) {
+      const float* src = sub.data() + (c % ns) * dsub_;
+      std::copy(src, src + dsub_, cb + c * dsub_);
+    }
+
+    for (std::size_t it = 0; it < iters; ++it) {
+      std::size_t changed = 0;
+      for (std::size_t i = 0; i < ns; ++i) {
+        const std::uint8_t a = nearest(j, sub.data() + i * dsub_);
+        if (a != assign[i] || it == 0) ++changed;
+        assign[i] = a;
+      }
+      if (changed == 0) break;
+
+      std::fill(sums.begin(), sums.end(), 0.0f);
+      std::fill(counts.begin(), counts.end(), 0);
+      for (std::size_t i = 0; i < ns; ++i) {
+        float* s = sums.data() + assign[i] * dsub_;
+        const float* x = sub.data() + i * dsub_;
+        for (std::size_t t = 0; t < dsub_; ++t) s[t] += x[t];
+        ++counts[assign[i]];
+      }
+      for (std::size_t c = 0; c < kCentroids; ++c) {
+        float* cc = cb + c * dsub_;
+        if (counts[c] == 0) {
+          // Empty cluster: reseed on a random sample point.
+          const float* src = sub.data() + pick(rng) * dsub_;
+          std::copy(src, src + dsub_, cc);
+          continue;
+        }
+        const float inv = 1.0f / static_cast<float>(counts[c]);
+        for (std::size_t t = 0; t < dsub_; ++t) cc[t] = sums[c * dsub_ + t] * inv;
+      }
+    }
+  }
+}
+
+void ProductQuantizer::set_centroids(std::vector<float> centroids) {
+  if (centroids.size() != m_ * kCentroids * dsub_) {
+    throw std::invalid_argument("ProductQuantizer::set_centroids: size mismatch");
+  }
+  centroids_ = std::move(centroids);
+  trained_ = true;
+}
+
+void ProductQuantizer::encode(const float* v, std::uint8_t* out) const {
+  for (std::size_t j = 0; j < m_; ++j) out[j] = nearest(j, v + j * dsub_);
+}
+
+void ProductQuantizer::decode(const std::uint8_t* code, float* out) const {
+  for (std::size_t j = 0; j < m_; ++j) {
+    const float* cc = centroid(j, code[j]);
+    std::copy(cc, cc + dsub_, out + j * dsub_);
+  }
+}
+
+ProductQuantizer::Table ProductQuantizer::prepare(Metric metric, const float* query,
+                                                  float q_inv) const {
+  Table t;
+  t.metric = metric;
+  t.inv_norm = q_inv;
+  t.table.resize(m_ * kCentroids);
+  for (std::size_t j = 0; j < m_; ++j) {
+    const float* qs = query + j * dsub_;
+    float* row = t.table.data() + j * kCentroids;
+    for (std::size_t c = 0; c < kCentroids; ++c) {
+      const float* cc = centroid(j, c);
+      float s = 0.0f;
+      if (metric == Metric::L2) {
+        for (std::size_t d = 0; d < dsub_; ++d) {
+          const float diff = qs[d] - cc[d];
+          s += diff * diff;
+        }
+      } else {
+        for (std::size_t d = 0; d < dsub_; ++d) s += qs[d] * cc[d];
+      }
+      row[c] = s;
+    }
+  }
+  return t;
+}
+
+float ProductQuantizer::distance(const Table& t, const std::uint8_t* code, float code_inv) const {
+  // Four independent sums so the lookups are not one serial add chain.
+  const float* tab = t.table.data();
+  float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+  std::size_t j = 0;
+  for (; j + 4 <= m_; j += 4) {
+    s0 += tab[(j + 0) * kCentroids + code[j + 0]];
+    s1 += tab[(j + 1) * kCentroids + code[j + 1]];
+    s2 += tab[(j + 2) * kCentroids + code[j + 2]];
+    s3 += tab[(j + 3) * kCentroids + code[j + 3]];
+  }
+  for (; j < m_; ++j) s0 += tab[j * kCentroids + code[j]];
+  const float s = (s0 + s1) + (s2 + s3);
+
+  switch (t.metric) {
+    case Metric::L2:
+      return s;
+    case Metric::COSINE:
+      return 1.0f - s * t.inv_norm * code_inv;
+    case Metric::IP:
+      return -s;
+    default:
+      return s;
+  }
+}
+
+}  // namespace vecdb
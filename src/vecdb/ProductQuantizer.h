@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Distance.h"
+
+namespace vecdb {
+
+// PQ: the vector is cut into m contiguous subspaces of dim/m floats and each
+// subvector is replaced by the index of its nearest centroid in a 256-entry
+// codebook learned by k-means for that subspace. A row shrinks from 4*dim to
+// m bytes (e.g. 768-d with m=96 is 32x smaller than float32).
+//
+// Distances are asymmetric (ADC): the query stays float. prepare() computes,
+// once per query, its partial distance to every centroid of every subspace
+// (an m x 256 table); scoring a code is then m table lookups and adds.
+class ProductQuantizer {
+ public:
+  static constexpr std::size_t kCentroids = 256;
+
+  ProductQuantizer() = default;
+
+  // Throws std::invalid_argument unless 0 < m <= dim and m divides dim.
+  ProductQuantizer(std::size_t dim, std::size_t m);
+
+  std::size_t dim() const { return dim_; }
+  std::size_t m() const { return m_; }             // subspaces == code bytes
+  std::size_t dsub() const { return dsub_; }       // floats per subspace
+  bool trained() const { return trained_; }
+
+  // Learn the m codebooks with Lloyd's k-means from n rows (rows[i] points at
+  // dim floats). At most kCentroids * kMaxPointsPerCentroid rows are sampled.
+  // With fewer than 256 distinct rows some centroids are duplicates.
+  void train(const float* const* rows, std::size_t n,
+             std::size_t iters = 20, unsigned seed = 123);
+
+  // Encode one row into m bytes. Precondition: trained().
+  void encode(const float* v, std::uint8_t* out) const;
+
+  // Decode m bytes back to the concatenated centroids (lossy).
+  void decode(const std::uint8_t* code, float* out) const;
+
+  // Codebooks laid out [subspace][centroid][dsub], m * 256 * dsub floats.
+  const std::vector<float>& centroids() const { return centroids_; }
+
+  // Install codebooks read from disk (same layout as centroids()).
+  void set_centroids(std::vector<float> centroids);
+
+  // Per-query ADC table: table[j * 256 + c] is the query's partial score
+  // against centroid c of subspace j (L2: squared distance; dot metrics: dot).
+  struct Table {
+    Metric metric = Metric::L2;
+    std::vector<float> table;
+    float inv_norm = 1.0f;  // COSINE: 1/||query||
+  };
+
+  // q_inv is 1/||query|| (only read for COSINE).
+  Table prepare(Metric metric, const float* query, float q_inv) const;
+
+  // Distance between a prepared query and a code, in the same units as
+  // Distance::distance(). code_inv is 1/||row|| of the original float row
+  // (only read for COSINE).
+  float distance(const Table& t, const std::uint8_t* code, float code_inv) const;
+
+ private:
+  static constexpr std::size_t kMaxPointsPerCentroid = 64;
+
+  const float* centroid(std::size_t sub, std::size_t c) const {
+    return centroids_.data() + (sub * kCentroids + c) * dsub_;
+  }
+
+  // Index of the nearest centroid of subspace sub to the subvector x.
+  std::uint8_t nearest(std::size_t sub, const float* x) const;
+
+  std::size_t dim_ = 0;
+  std::size_t m_ = 0;
+  std::size_t dsub_ = 0;
+  bool trained_ = false;
+  std::vector<float> centroids_;
+};
+
+}  // namespace vecdb
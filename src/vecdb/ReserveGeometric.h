@@ -0,0 +1,16 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace vecdb {
+
+// reserve(n) that keeps growth geometric: repeated reserve(size() + batch)
+// calls would otherwise reallocate to exactly n each time, so loading in
+// batches would copy every array once per batch.
+template <class C>
+inline void reserve_geometric(C& c, std::size_t n) {
+  if (n > c.capacity()) c.reserve(std::max(n, 2 * c.capacity()));
+}
+
+}  // namespace vecdb
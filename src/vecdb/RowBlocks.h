@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "AlignedAllocator.h"
+
+namespace vecdb {
+
+// Fixed-stride rows kept in blocks of kRowsPerBlock rows, each block a
+// separate cache-line aligned allocation. Growing only appends blocks, so
+// existing rows are never copied and row pointers stay valid until clear().
+// Appending costs the same at any size, and peak memory during growth is
+// one block over the live size rather than 2x.
+template <class T>
+class RowBlocks {
+ public:
+  static constexpr std::size_t kBlockShift = 8;
+  static constexpr std::size_t kRowsPerBlock = std::size_t{1} << kBlockShift;
+
+  RowBlocks() = default;
+  explicit RowBlocks(std::size_t stride) : stride_(stride) {}
+
+  // Elements per row.
+  std::size_t stride() const { return stride_; }
+
+  // Rows in use. Capacity is always a whole number of blocks.
+  std::size_t rows() const { return rows_; }
+
+  // Allocates blocks for at least n rows without changing rows().
+  void reserve(std::size_t n) {
+    const std::size_t blocks = (n + kRowsPerBlock - 1) >> kBlockShift;
+    if (blocks > blocks_.capacity()) blocks_.reserve(std::max(blocks, 2 * blocks_.capacity()));
+    allocate_(n);
+  }
+
+  // Grows to n rows; new rows are zero-filled. Never shrinks (see clear()).
+  void grow(std::size_t n) {
+    allocate_(n);
+    if (n > rows_) rows_ = n;
+  }
+
+  void clear() {
+    blocks_.clear();
+    rows_ = 0;
+  }
+
+  // Precondition: i < rows().
+  T* row(std::size_t i) {
+    return blocks_[i >> kBlockShift].data() + (i & (kRowsPerBlock - 1)) * stride_;
+  }
+  const T* row(std::size_t i) const {
+    return blocks_[i >> kBlockShift].data() + (i & (kRowsPerBlock - 1)) * stride_;
+  }
+
+ private:
+  void allocate_(std::size_t n) {
+    while (blocks_.size() * kRowsPerBlock < n) {
+      blocks_.emplace_back(kRowsPerBlock * stride_, T{});
+    }
+  }
+
+  std::size_t stride_ = 0;
+  std::size_t rows_ = 0;
+  // Moving the outer vector moves each block's buffer, not its contents.
+  std::vector<AlignedVector<T>> blocks_;
+};
+
+}  // namespace vecdb
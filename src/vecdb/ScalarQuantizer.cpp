@@ -0,0 +1,89 @@
+#include "ScalarQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "DistanceSimd.h"
+
+namespace vecdb {
+
+void ScalarQuantizer::train(const float* const* rows, std::size_t n) {
+  if (dim_ == 0) throw std::logic_error("ScalarQuantizer::train: dim is 0");
+
+  std::vector<float> vmax(dim_, -std::numeric_limits<float>::infinity());
+  vmin_.assign(dim_, std::numeric_limits<float>::infinity());
+  for (std::size_t i = 0; i < n; ++i) {
+    const float* v = rows[i];
+    for (std::size_t d = 0; d < dim_; ++d) {
+      vmin_[d] = std::min(vmin_[d], v[d]);
+      vmax[d] = std::max(vmax[d], v[d]);
+    }
+  }
+
+  scale_.assign(dim_, 0.0f);
+  inv_scale_.assign(dim_, 0.0f);
+  for (std::size_t d = 0; d < dim_; ++d) {
+    if (n == 0) {
+      vmin_[d] = 0.0f;
+      continue;
+    }
+    const float range = vmax[d] - vmin_[d];
+    if (range > 0.0f) {
+      scale_[d] = range / 255.0f;
+      inv_scale_[d] = 255.0f / range;
+    }
+  }
+
+  const auto& k = simd::active();
+  l2_ = k.sq8_l2;
+  dot_ = k.sq8_dot;
+  trained_ = true;
+}
+
+void ScalarQuantizer::encode(const float* v, std::uint8_t* out) const {
+  for (std::size_t d = 0; d < dim_; ++d) {
+    float c = std::nearbyint((v[d] - vmin_[d]) * inv_scale_[d]);
+    c = std::min(255.0f, std::max(0.0f, c));
+    out[d] = static_cast<std::uint8_t>(c);
+  }
+}
+
+void ScalarQuantizer::decode(const std::uint8_t* code, float* out) const {
+  for (std::size_t d = 0; d < dim_; ++d) {
+    out[d] = vmin_[d] + scale_[d] * static_cast<float>(code[d]);
+  }
+}
+
+ScalarQuantizer::Query ScalarQuantizer::prepare(Metric metric, const float* query,
+                                                float q_inv) const {
+  Query q;
+  q.metric = metric;
+  q.inv_norm = q_inv;
+  q.q.resize(dim_);
+  if (metric == Metric::L2) {
+    // ||query - (vmin + scale*c)||^2 = sum (qm - scale*c)^2
+    for (std::size_t d = 0; d < dim_; ++d) q.q[d] = query[d] - vmin_[d];
+  } else {
+    // dot(query, vmin + scale*c) = dot(query, vmin) + dot(query*scale, c)
+    for (std::size_t d = 0; d < dim_; ++d) q.q[d] = query[d] * scale_[d];
+    q.offset = Distance::dot(query, vmin_.data(), dim_);
+  }
+  return q;
+}
+
+float ScalarQuantizer::distance(const Query& q, const std::uint8_t* code, float code_inv) const {
+  switch (q.metric) {
+    case Metric::L2:
+      return l2_(q.q.data(), scale_.data(), code, dim_);
+    case Metric::COSINE:
+      return 1.0f - (q.offset + dot_(q.q.data(), code, dim_)) * q.inv_norm * code_inv;
+    case Metric::IP:
+      return -(q.offset + dot_(q.q.data(), code, dim_));
+    default:
+      return l2_(q.q.data(), scale_.data(), code, dim_);
+  }
+}
+
+}  // namespace vecdb
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Distance.h"
+
+namespace vecdb {
+
+// SQ8: each dimension is mapped linearly onto 0..255 using a per-dimension
+// [min, max] range learned from the data, so a row shrinks from 4*dim to dim
+// bytes. Values outside the trained range are clamped.
+//
+// Distances are asymmetric: the query stays float and codes are widened
+// on the fly inside the SIMD kernels (decoded value = min + scale * code).
+class ScalarQuantizer {
+ public:
+  ScalarQuantizer() = default;
+  explicit ScalarQuantizer(std::size_t dim) : dim_(dim) {}
+
+  std::size_t dim() const { return dim_; }
+  bool trained() const { return trained_; }
+
+  // Learn per-dimension min/max from n rows. rows[i] points at dim floats.
+  void train(const float* const* rows, std::size_t n);
+
+  // Encode one row into dim bytes. Precondition: trained().
+  void encode(const float* v, std::uint8_t* out) const;
+
+  // Decode dim bytes back to floats (lossy). Precondition: trained().
+  void decode(const std::uint8_t* code, float* out) const;
+
+  const std::vector<float>& vmin() const { return vmin_; }
+  const std::vector<float>& scale() const { return scale_; }
+
+  // Query-side terms precomputed once per search so scoring a code is a
+  // single kernel call.
+  struct Query {
+    Metric metric = Metric::L2;
+    std::vector<float> q;  // L2: query - vmin; dot metrics: query * scale
+    float offset = 0.0f;   // dot metrics: dot(query, vmin)
+    float inv_norm = 1.0f; // COSINE: 1/||query||
+  };
+
+  // q_inv is 1/||query|| (only read for COSINE).
+  Query prepare(Metric metric, const float* query, float q_inv) const;
+
+  // Distance between a prepared query and a code, in the same units as
+  // Distance::distance(). code_inv is 1/||row|| of the original float row
+  // (only read for COSINE).
+  float distance(const Query& q, const std::uint8_t* code, float code_inv) const;
+
+ private:
+  std::size_t dim_ = 0;
+  bool trained_ = false;
+  std::vector<float> vmin_;
+  std::vector<float> scale_;      // (max - min) / 255
+  std::vector<float> inv_scale_;  // 1 / scale, 0 for constant dimensions
+
+  // SIMD code kernels for the level selected at startup (set by train()).
+  float (*l2_)(const float* qm, const float* scale, const std::uint8_t* code,
+               std::size_t dim) = nullptr;
+  float (*dot_)(const float* qs, const std::uint8_t* code, std::size_t dim) = nullptr;
+};
+
+}  // namespace vecdb
@@ -9,6 +9,7 @@
 #include <cctype>
 #include <cstdint>
 #include <cstring>
+#include <utility>
 
 #include "Metadata.h"
 
@@ -66,12 +67,14 @@ static std::string metric_to_string(Metric m) {
   switch (m) {
     case Metric::L2: return "L2";
     case Metric::COSINE: return "COSINE";
+    case Metric::IP: return "IP";
     default: return "L2";
   }
 }
 static Metric metric_from_string(const std::string& s) {
   if (s == "L2") return Metric::L2;
   if (s == "COSINE") return Metric::COSINE;
+  if (s == "IP") return Metric::IP;
   return Metric::L2;
 }
 
@@ -151,6 +154,12 @@ Serializer::Manifest Serializer::read_manifest(const std::string& dir) {
   mf.version = static_cast<int>(find_json_int(text, "version", 1));
   mf.dim = static_cast<std::size_t>(find_json_int(text, "dim", 0));
   mf.metric = metric_from_string(find_json_string(text, "metric"));
+  mf.normalize = find_json_bool(text, "normalize", false);
+  mf.sq8 = find_json_bool(text, "sq8", false);
+  mf.pq_m = static_cast<std::size_t>(find_json_int(text, "pq_m", 0));
+  mf.binary_shortlist = static_cast<std::size_t>(find_json_int(text, "binary_shortlist", 0));
+  mf.row_format = row_format_from_string(find_json_string(text, "row_format"));
+  mf.pad_rows = find_json_bool(text, "pad_rows", false);
 
   mf.hnsw_params.M = static_cast<std::size_t>(find_json_int(text, "M", 16));
   mf.hnsw_params.M0 = static_cast<std::size_t>(find_json_int(text, "M0", 32));
@@ -173,6 +182,12 @@ void Serializer::write_manifest(const std::string& dir, const Manifest& mf) {
   ss << "  \"version\": " << mf.version << ",\n";
   ss << "  \"dim\": " << mf.dim << ",\n";
   ss << "  \"metric\": \"" << metric_to_string(mf.metric) << "\",\n";
+  ss << "  \"normalize\": " << (mf.normalize ? "true" : "false") << ",\n";
+  ss << "  \"sq8\": " << (mf.sq8 ? "true" : "false") << ",\n";
+  ss << "  \"pq_m\": " << mf.pq_m << ",\n";
+  ss << "  \"binary_shortlist\": " << mf.binary_shortlist << ",\n";
+  ss << "  \"row_format\": \"" << row_format_to_string(mf.row_format) << "\",\n";
+  ss << "  \"pad_rows\": " << (mf.pad_rows ? "true" : "false") << ",\n";
   ss << "  \"hnsw\": {\n";
   ss << "    \"M\": " << mf.hnsw_params.M << ",\n";
   ss << "    \"M0\": " << mf.hnsw_params.M0 << ",\n";
@@ -189,33 +204,41 @@ void Serializer::write_manifest(const std::string& dir, const Manifest& mf) {
 // ---------------- VectorStore ----------------
 
 static constexpr std::uint64_t MAGIC_VEC = 0x31565F434556uLL;   // "VECV_1" (loosely)
+static constexpr std::uint64_t MAGIC_VEC_HALF = 0x31485F434556uLL;  // "VECH_1": + u64 format
 static constexpr std::uint64_t MAGIC_ALV = 0x31565F564C41uLL;   // "ALV_1"
+static constexpr std::uint64_t MAGIC_PQ  = 0x31565F5150uLL;     // "PQ_V1"
 
 void Serializer::save_store(const std::string& dir, const VectorStore& store) {
   const std::size_t N = store.size();
   const std::size_t dim = store.dim();
 
-  // vectors.bin
+  // vectors.bin: every slot's stored row, dead ones included. A saved HNSW
+  // graph still routes through tombstones (see Hnsw::search), so they must
+  // load back with the same position and norm.
   {
     fs::path vp = pjoin(dir, "vectors.bin");
     std::ofstream out(vp, std::ios::binary);
     if (!out) throw std::runtime_error("Serializer: cannot open vectors.bin for write");
 
-    write_u64(out, MAGIC_VEC);
-    write_u64(out, static_cast<std::uint64_t>(N));
-    write_u64(out, static_cast<std::uint64_t>(dim));
+    if (store.half_rows()) {
+      // Same layout with 2-byte elements; the header also records the format.
+      write_u64(out, MAGIC_VEC_HALF);
+      write_u64(out, static_cast<std::uint64_t>(N));
+      write_u64(out, static_cast<std::uint64_t>(dim));
+      write_u64(out, static_cast<std::uint64_t>(store.row_format()));
 
-    for (std::size_t i = 0; i < N; ++i) {
-      const float* ptr = store.get_ptr(i);
-      if (!ptr) {
-        // dead slot -> still write stored bytes if any; our get_ptr hides dead.
-        // so we write zeros; correctness doesn't depend on dead vectors.
-        for (std::size_t d = 0; d < dim; ++d) {
-          float z = 0.f;
-          out.write(reinterpret_cast<const char*>(&z), sizeof(float));
-        }
-      } else {
-        out.write(reinterpret_cast<const char*>(ptr), static_cast<std::streamsize>(dim * sizeof(float)));
+      for (std::size_t i = 0; i < N; ++i) {
+        out.write(reinterpret_cast<const char*>(store.half_row_ptr(i)),
+                  static_cast<std::streamsize>(dim * sizeof(std::uint16_t)));
+      }
+    } else {
+      write_u64(out, MAGIC_VEC);
+      write_u64(out, static_cast<std::uint64_t>(N));
+      write_u64(out, static_cast<std::uint64_t>(dim));
+
+      for (std::size_t i = 0; i < N; ++i) {
+        out.write(reinterpret_cast<const char*>(store.row_ptr(i)),
+                  static_cast<std::streamsize>(dim * sizeof(float)));
       }
     }
 
@@ -261,6 +284,34 @@ void Serializer::save_store(const std::string& dir, const VectorStore& store) {
       out << metadata::encode(store.metadata_at(i)) << "\n";
     }
   }
+
+  // pq.bin: header, codebooks [m][256][dsub], then m code bytes per slot.
+  {
+    fs::path pp = pjoin(dir, "pq.bin");
+    if (!store.has_pq()) {
+      std::error_code ec;
+      fs::remove(pp, ec);
+    } else {
+      const ProductQuantizer& pq = store.pq();
+      std::ofstream out(pp, std::ios::binary);
+      if (!out) throw std::runtime_error("Serializer: cannot open pq.bin for write");
+
+      write_u64(out, MAGIC_PQ);
+      write_u64(out, static_cast<std::uint64_t>(N));
+      write_u64(out, static_cast<std::uint64_t>(dim));
+      write_u64(out, static_cast<std::uint64_t>(pq.m()));
+
+      const auto& cb = pq.centroids();
+      out.write(reinterpret_cast<const char*>(cb.data()),
+                static_cast<std::streamsize>(cb.size() * sizeof(float)));
+      if (N > 0) {
+        out.write(reinterpret_cast<const char*>(store.pq_code(0)),
+                  static_cast<std::streamsize>(N * pq.m()));
+      }
+
+      if (!out) throw std::runtime_error("Serializer: write failed: pq.bin");
+    }
+  }
 }
 
 void Serializer::load_store(const std::string& dir, VectorStore& store) {
@@ -272,6 +323,7 @@ void Serializer::load_store(const std::string& dir, VectorStore& store) {
   std::size_t N = 0;
   std::size_t dim = 0;
   std::vector<float> vectors;
+  std::vector<std::uint16_t> half_rows;  // set instead when the formats match
 
   // vectors.bin
   {
@@ -279,7 +331,9 @@ void Serializer::load_store(const std::string& dir, VectorStore& store) {
     if (!in) throw std::runtime_error("Serializer: cannot open vectors.bin for read");
 
     std::uint64_t magic = read_u64(in);
-    if (magic != MAGIC_VEC) throw std::runtime_error("Serializer: bad vectors.bin magic");
+    if (magic != MAGIC_VEC && magic != MAGIC_VEC_HALF) {
+      throw std::runtime_error("Serializer: bad vectors.bin magic");
+    }
     N = static_cast<std::size_t>(read_u64(in));
     dim = static_cast<std::size_t>(read_u64(in));
 
@@ -287,10 +341,31 @@ void Serializer::load_store(const std::string& dir, VectorStore& store) {
       throw std::runtime_error("Serializer: vectors.bin dim mismatch vs store.dim()");
     }
 
-    vectors.resize(N * dim);
-    in.read(reinterpret_cast<char*>(vectors.data()),
-            static_cast<std::streamsize>(vectors.size() * sizeof(float)));
-    if (!in) throw std::runtime_error("Serializer: read failed: vectors.bin");
+    if (magic == MAGIC_VEC_HALF) {
+      const std::uint64_t f = read_u64(in);
+      if (f != static_cast<std::uint64_t>(RowFormat::F16) &&
+          f != static_cast<std::uint64_t>(RowFormat::BF16)) {
+        throw std::runtime_error("Serializer: bad vectors.bin row format");
+      }
+      const RowFormat format = static_cast<RowFormat>(f);
+
+      half_rows.resize(N * dim);
+      in.read(reinterpret_cast<char*>(half_rows.data()),
+              static_cast<std::streamsize>(half_rows.size() * sizeof(std::uint16_t)));
+      if (!in) throw std::runtime_error("Serializer: read failed: vectors.bin");
+
+      // A store in another format gets floats and converts them itself.
+      if (format != store.row_format()) {
+        vectors.resize(N * dim);
+        decode_half_row(format, half_rows.data(), half_rows.size(), vectors.data());
+        half_rows.clear();
+      }
+    } else {
+      vectors.resize(N * dim);
+      in.read(reinterpret_cast<char*>(vectors.data()),
+              static_cast<std::streamsize>(vectors.size() * sizeof(float)));
+      if (!in) throw std::runtime_error("Serializer: read failed: vectors.bin");
+    }
   }
 
   // alive.bin
@@ -345,7 +420,37 @@ void Serializer::load_store(const std::string& dir, VectorStore& store) {
     meta.resize(N);
   }
 
-  store.load_from_disk(N, vectors, alive, ids, meta);
+  if (!half_rows.empty()) {
+    store.load_from_disk(N, half_rows, alive, ids, meta);
+  } else {
+    store.load_from_disk(N, vectors, alive, ids, meta);
+  }
+
+  // pq.bin (optional)
+  fs::path pp = pjoin(dir, "pq.bin");
+  if (fs::exists(pp)) {
+    std::ifstream in(pp, std::ios::binary);
+    if (!in) throw std::runtime_error("Serializer: cannot open pq.bin for read");
+
+    std::uint64_t magic = read_u64(in);
+    if (magic != MAGIC_PQ) throw std::runtime_error("Serializer: bad pq.bin magic");
+    std::size_t n2 = static_cast<std::size_t>(read_u64(in));
+    std::size_t dim2 = static_cast<std::size_t>(read_u64(in));
+    std::size_t m = static_cast<std::size_t>(read_u64(in));
+    if (n2 != N) throw std::runtime_error("Serializer: pq.bin N mismatch");
+    if (dim2 != dim) throw std::runtime_error("Serializer: pq.bin dim mismatch");
+
+    ProductQuantizer pq(dim, m);
+    std::vector<float> cb(m * ProductQuantizer::kCentroids * pq.dsub());
+    in.read(reinterpret_cast<char*>(cb.data()),
+            static_cast<std::streamsize>(cb.size() * sizeof(float)));
+    std::vector<std::uint8_t> codes(N * m);
+    in.read(reinterpret_cast<char*>(codes.data()), static_cast<std::streamsize>(codes.size()));
+    if (!in) throw std::runtime_error("Serializer: read failed: pq.bin");
+
+    pq.set_centroids(std::move(cb));
+    store.restore_pq(std::move(pq), std::move(codes));
+  }
 }
 
 // ---------------- HNSW ----------------
@@ -15,11 +15,12 @@ namespace vecdb {
 //
 // v1 on-disk layout (minimal, readable, versioned):
 //   <dir>/manifest.json   -- metadata (dim, metric, version, hnsw params)
-//   <dir>/vectors.bin     -- contiguous float32 vectors
+//   <dir>/vectors.bin     -- contiguous vectors (float32, or 16-bit per row_format)
 //   <dir>/alive.bin       -- alive bitmap (uint8_t per index)
 //   <dir>/ids.txt         -- index -> id (one per line, empty for dead slots)
 //   <dir>/meta.txt        -- index -> metadata (one line per index, key=value;...)
 //   <dir>/hnsw.bin        -- HNSW graph structure (binary)
+//   <dir>/pq.bin          -- PQ codebooks + per-slot codes (only if enabled)
 //
 // Notes:
 // - We keep formats simple and explicit for clarity.
@@ -33,6 +34,12 @@ class Serializer {
     std::size_t dim = 0;
     Metric metric = Metric::L2;
     Hnsw::Params hnsw_params{};
+    bool normalize = false;  // vectors were L2-normalized on ingest
+    bool sq8 = false;        // HNSW search traverses SQ8 codes (rebuilt on open)
+    std::size_t pq_m = 0;    // PQ subspaces for code search, 0 = off (pq.bin)
+    std::size_t binary_shortlist = 0;  // Hamming prefilter + rerank, 0 = off
+    RowFormat row_format = RowFormat::F32;  // element type in memory and vectors.bin
+    bool pad_rows = false;   // in-memory row stride padded to kRowPad (file layout unchanged)
   };
 
   // Read / write manifest.json
@@ -41,7 +48,8 @@ class Serializer {
 
   // -------- VectorStore --------
 
-  // Save all vector data, alive flags, and id mapping.
+  // Save all vector data, alive flags, and id mapping (plus PQ codebooks and
+  // codes when the store has them; a stale pq.bin is removed otherwise).
   static void save_store(const std::string& dir, const VectorStore& store);
 
   // Load vector data, alive flags, and id mapping into an existing store.
@@ -2,44 +2,182 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <utility>
+
+#include "Distance.h"
+#include "ReserveGeometric.h"
 
 namespace vecdb {
 
-VectorStore::VectorStore(std::size_t dim) : dim_(dim) {
+VectorStore::VectorStore(std::size_t dim, RowFormat format, bool pad_rows)
+    : dim_(dim),
+      stride_(pad_rows ? (dim + kRowPad - 1) / kRowPad * kRowPad : dim),
+      pad_rows_(pad_rows),
+      format_(format),
+      data_(stride_),
+      half_(dim),
+      sq8_(dim),
+      binary_(dim) {
   if (dim_ == 0) throw std::invalid_argument("VectorStore: dim must be > 0");
+  if (pad_rows_ && half_rows()) {
+    throw std::invalid_argument("VectorStore: pad_rows requires F32 rows");
+  }
+}
+
+const float* VectorStore::aligned_query(const float* query, AlignedVector<float>& buf) const {
+  if (!pad_rows_) return query;
+  buf.assign(stride_, 0.0f);
+  std::copy(query, query + dim_, buf.begin());
+  return buf.data();
 }
 
-void VectorStore::validate_dim_(const std::vector<float>& vec) const {
+void VectorStore::validate_dim_(VectorView vec) const {
   if (vec.size() != dim_) {
     throw std::invalid_argument("VectorStore: vector dim mismatch");
   }
 }
 
+std::vector<const float*> VectorStore::alive_rows_f32_(std::vector<float>& decoded) const {
+  std::vector<const float*> rows;
+  rows.reserve(alive_count());
+  if (half_rows()) {
+    decoded.resize(size() * dim_);
+    alive_.for_each([&](std::size_t i) { rows.push_back(row_f32(i, decoded.data() + i * dim_)); });
+    return rows;
+  }
+  alive_.for_each([&](std::size_t i) { rows.push_back(ptr_at_(i)); });
+  return rows;
+}
+
+const float* VectorStore::row_f32(std::size_t index, float* scratch) const {
+  if (!half_rows()) return ptr_at_(index);
+  decode_half_row(format_, half_row_ptr(index), dim_, scratch);
+  return scratch;
+}
+
+void VectorStore::enable_sq8() {
+  std::vector<float> decoded;
+  std::vector<const float*> rows = alive_rows_f32_(decoded);
+  sq8_ = ScalarQuantizer(dim_);
+  sq8_.train(rows.data(), rows.size());
+
+  std::vector<float> scratch(dim_);
+  sq8_codes_.assign(size() * dim_, 0);
+  for (std::size_t i = 0; i < size(); ++i) {
+    sq8_.encode(row_f32(i, scratch.data()), sq8_codes_.data() + i * dim_);
+  }
+}
+
+void VectorStore::disable_sq8() {
+  sq8_ = ScalarQuantizer(dim_);
+  sq8_codes_.clear();
+  sq8_codes_.shrink_to_fit();
+}
+
+void VectorStore::enable_pq(std::size_t m) {
+  std::vector<float> decoded;
+  std::vector<const float*> rows = alive_rows_f32_(decoded);
+  ProductQuantizer pq(dim_, m);
+  pq.train(rows.data(), rows.size());
+  pq_ = std::move(pq);
+
+  std::vector<float> scratch(dim_);
+  pq_codes_.assign(size() * m, 0);
+  for (std::size_t i = 0; i < size(); ++i) {
+    pq_.encode(row_f32(i, scratch.data()), pq_codes_.data() + i * m);
+  }
+}
+
+void VectorStore::disable_pq() {
+  pq_ = ProductQuantizer();
+  pq_codes_.clear();
+  pq_codes_.shrink_to_fit();
+}
+
+void VectorStore::restore_pq(ProductQuantizer pq, std::vector<std::uint8_t> codes) {
+  if (pq.dim() != dim_ || !pq.trained()) {
+    throw std::invalid_argument("VectorStore::restore_pq: quantizer does not match store");
+  }
+  if (codes.size() != size() * pq.m()) {
+    throw std::invalid_argument("VectorStore::restore_pq: codes size mismatch");
+  }
+  pq_ = std::move(pq);
+  pq_codes_ = std::move(codes);
+}
+
+void VectorStore::enable_binary() {
+  const std::size_t w = binary_.words();
+  std::vector<float> scratch(dim_);
+  binary_codes_.assign(size() * w, 0);
+  for (std::size_t i = 0; i < size(); ++i) {
+    binary_.encode(row_f32(i, scratch.data()), binary_codes_.data() + i * w);
+  }
+  has_binary_ = true;
+}
+
+void VectorStore::disable_binary() {
+  has_binary_ = false;
+  binary_codes_.clear();
+  binary_codes_.shrink_to_fit();
+}
+
+void VectorStore::write_row_(std::size_t index, const float* v) {
+  if (!half_rows()) {
+    std::copy(v, v + dim_, ptr_at_(index));
+    inv_norms_[index] = Distance::inv_norm(v, dim_);
+    encode_codes_(index, v);
+    return;
+  }
+  // Norms and codes follow the rounded row, so they agree with what a
+  // reload would compute from vectors.bin.
+  encode_half_row(format_, v, dim_, half_.row(index));
+  std::vector<float> rounded(dim_);
+  row_f32(index, rounded.data());
+  inv_norms_[index] = Distance::inv_norm(rounded.data(), dim_);
+  encode_codes_(index, rounded.data());
+}
+
+void VectorStore::encode_codes_(std::size_t index, const float* row) {
+  if (has_sq8()) {
+    if (sq8_codes_.size() < (index + 1) * dim_) sq8_codes_.resize((index + 1) * dim_);
+    sq8_.encode(row, sq8_codes_.data() + index * dim_);
+  }
+  if (has_pq()) {
+    const std::size_t m = pq_.m();
+    if (pq_codes_.size() < (index + 1) * m) pq_codes_.resize((index + 1) * m);
+    pq_.encode(row, pq_codes_.data() + index * m);
+  }
+  if (has_binary_) {
+    const std::size_t w = binary_.words();
+    if (binary_codes_.size() < (index + 1) * w) binary_codes_.resize((index + 1) * w);
+    binary_.encode(row, binary_codes_.data() + index * w);
+  }
+}
+
 float* VectorStore::ptr_at_(std::size_t index) {
-  return data_.data() + index * dim_;
+  return data_.row(index);
 }
 
 const float* VectorStore::ptr_at_(std::size_t index) const {
-  return data_.data() + index * dim_;
+  return data_.row(index);
 }
 
 bool VectorStore::is_alive(std::size_t index) const {
   if (index >= alive_.size()) return false;
-  return alive_[index] != 0;
+  return alive_.test(index);
 }
 
 bool VectorStore::contains(const std::string& id) const {
-  auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) return false;
-  std::size_t idx = it->second;
+  const std::size_t idx = ids_.find(id);
+  if (idx == IdIndex::npos) return false;
   return is_alive(idx);
 }
 
-const std::string& VectorStore::id_at(std::size_t index) const {
+std::string_view VectorStore::id_at(std::size_t index) const {
   if (index >= ids_.size()) {
     throw std::out_of_range("VectorStore::id_at: index out of range");
   }
-  return ids_[index];
+  return ids_.id(index);
 }
 
 const Metadata& VectorStore::metadata_at(std::size_t index) const {
@@ -50,122 +188,158 @@ const Metadata& VectorStore::metadata_at(std::size_t index) const {
 }
 
 const Metadata* VectorStore::metadata_ptr(const std::string& id) const {
-  auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) return nullptr;
-  std::size_t idx = it->second;
+  const std::size_t idx = ids_.find(id);
+  if (idx == IdIndex::npos) return nullptr;
   if (!is_alive(idx)) return nullptr;
   return &meta_[idx];
 }
 
 const float* VectorStore::get_ptr(std::size_t index) const {
+  if (half_rows()) throw std::logic_error("VectorStore::get_ptr: rows are not stored as float");
   if (index >= size()) return nullptr;
   if (!is_alive(index)) return nullptr;
   return ptr_at_(index);
 }
 
 float* VectorStore::get_mut_ptr(std::size_t index) {
+  if (half_rows()) throw std::logic_error("VectorStore::get_mut_ptr: rows are not stored as float");
   if (index >= size()) return nullptr;
   if (!is_alive(index)) return nullptr;
   return ptr_at_(index);
 }
 
 const float* VectorStore::get_ptr(const std::string& id) const {
-  auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) return nullptr;
-  std::size_t idx = it->second;
+  const std::size_t idx = ids_.find(id);
+  if (idx == IdIndex::npos) return nullptr;
   return get_ptr(idx);
 }
 
 float* VectorStore::get_mut_ptr(const std::string& id) {
-  auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) return nullptr;
-  std::size_t idx = it->second;
+  const std::size_t idx = ids_.find(id);
+  if (idx == IdIndex::npos) return nullptr;
   return get_mut_ptr(idx);
 }
 
 bool VectorStore::try_get_index(const std::string& id, std::size_t& out_index) const {
-  auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) return false;
-  std::size_t idx = it->second;
+  const std::size_t idx = ids_.find(id);
+  if (idx == IdIndex::npos) return false;
   if (!is_alive(idx)) return false;
   out_index = idx;
   return true;
 }
 
 std::size_t VectorStore::insert(const std::string& id,
-                                const std::vector<float>& vec,
-                                const Metadata& meta) {
+                                VectorView vec,
+                                Metadata meta) {
   validate_dim_(vec);
   if (id.empty()) throw std::invalid_argument("VectorStore::insert: id cannot be empty");
 
-  auto it = id_to_index_.find(id);
-  if (it != id_to_index_.end()) {
-    std::size_t idx = it->second;
+  std::size_t idx = ids_.find(id);
+  if (idx != IdIndex::npos) {
     if (is_alive(idx)) {
       throw std::runtime_error("VectorStore::insert: id already exists");
     }
     // existed but dead -> revive at same index
-    std::copy(vec.begin(), vec.end(), ptr_at_(idx));
-    alive_[idx] = 1;
-    meta_[idx] = meta;
-    // keep ids_[idx] as id
+    write_row_(idx, vec.data());
+    alive_.set(idx);
+    meta_[idx] = std::move(meta);
     return idx;
   }
 
   // Append new slot
-  std::size_t idx = ids_.size();
-  ids_.push_back(id);
-  meta_.push_back(meta);
-  alive_.push_back(1);
-
-  data_.resize(ids_.size() * dim_);
-  std::copy(vec.begin(), vec.end(), ptr_at_(idx));
-
-  id_to_index_[id] = idx;
+  idx = ids_.size();
+  ids_.append(id);
+  meta_.push_back(std::move(meta));
+  alive_.push_back(true);
+  inv_norms_.push_back(0.0f);
+
+  if (half_rows()) {
+    half_.grow(ids_.size());
+  } else {
+    data_.grow(ids_.size());
+  }
+  write_row_(idx, vec.data());
   return idx;
 }
 
 std::size_t VectorStore::upsert(const std::string& id,
-                                const std::vector<float>& vec,
-                                const Metadata& meta) {
+                                VectorView vec,
+                                Metadata meta) {
   validate_dim_(vec);
   if (id.empty()) throw std::invalid_argument("VectorStore::upsert: id cannot be empty");
+  return upsert_row_(id, vec.data(), std::move(meta));
+}
 
-  auto it = id_to_index_.find(id);
-  if (it != id_to_index_.end()) {
-    std::size_t idx = it->second;
+void VectorStore::upsert_batch(const std::vector<std::string>& ids,
+                               VectorView vectors,
+                               std::vector<Metadata> meta) {
+  if (vectors.size() != ids.size() * dim_) {
+    throw std::invalid_argument("VectorStore::upsert_batch: vectors size mismatch");
+  }
+  if (!meta.empty() && meta.size() != ids.size()) {
+    throw std::invalid_argument("VectorStore::upsert_batch: meta size mismatch");
+  }
+  for (const auto& id : ids) {
+    if (id.empty()) throw std::invalid_argument("VectorStore::upsert_batch: id cannot be empty");
+  }
+
+  reserve(size() + ids.size());
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    upsert_row_(ids[i], vectors.data() + i * dim_, meta.empty() ? Metadata{} : std::move(meta[i]));
+  }
+}
+
+std::size_t VectorStore::upsert_row_(const std::string& id, const float* vec,
+                                     Metadata&& meta) {
+  std::size_t idx = ids_.find(id);
+  if (idx != IdIndex::npos) {
     // overwrite (even if dead -> revive)
-    std::copy(vec.begin(), vec.end(), ptr_at_(idx));
-    alive_[idx] = 1;
-    if (ids_[idx].empty()) ids_[idx] = id;
-    meta_[idx] = meta;
+    write_row_(idx, vec);
+    alive_.set(idx);
+    meta_[idx] = std::move(meta);
     return idx;
   }
 
   // new id -> append
-  std::size_t idx = ids_.size();
-  ids_.push_back(id);
-  meta_.push_back(meta);
-  alive_.push_back(1);
-
-  data_.resize(ids_.size() * dim_);
-  std::copy(vec.begin(), vec.end(), ptr_at_(idx));
-
-  id_to_index_[id] = idx;
+  idx = ids_.size();
+  ids_.append(id);
+  meta_.push_back(std::move(meta));
+  alive_.push_back(true);
+  inv_norms_.push_back(0.0f);
+
+  if (half_rows()) {
+    half_.grow(ids_.size());
+  } else {
+    data_.grow(ids_.size());
+  }
+  write_row_(idx, vec);
   return idx;
 }
 
-bool VectorStore::remove(const std::string& id) {
-  auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) return false;
+void VectorStore::reserve(std::size_t n) {
+  ids_.reserve(n);
+  reserve_geometric(meta_, n);
+  alive_.reserve(n);
+  reserve_geometric(inv_norms_, n);
+  if (half_rows()) {
+    half_.reserve(n);
+  } else {
+    data_.reserve(n);
+  }
+  if (has_sq8()) reserve_geometric(sq8_codes_, n * dim_);
+  if (has_pq()) reserve_geometric(pq_codes_, n * pq_.m());
+  if (has_binary_) reserve_geometric(binary_codes_, n * binary_.words());
+}
 
-  std::size_t idx = it->second;
+bool VectorStore::remove(const std::string& id) {
+  const std::size_t idx = ids_.find(id);
+  if (idx == IdIndex::npos) return false;
   if (!is_alive(idx)) return false;
 
-  alive_[idx] = 0;
+  alive_.reset(idx);
 
   // IMPORTANT:
-  // We intentionally keep ids_[idx] and id_to_index_[id] so that an "upsert"
+  // We intentionally keep the id mapped to idx in ids_ so that an "upsert"
   // can revive the same id at the same stable index during the same run.
   // (Persistence behavior depends on whether ids for dead slots are saved.)
   return true;
@@ -173,10 +347,14 @@ bool VectorStore::remove(const std::string& id) {
 
 void VectorStore::clear() {
   data_.clear();
+  half_.clear();
+  inv_norms_.clear();
+  disable_sq8();
+  disable_pq();
+  disable_binary();
   alive_.clear();
   ids_.clear();
   meta_.clear();
-  id_to_index_.clear();
 }
 
 void VectorStore::load_from_disk(std::size_t N,
@@ -188,6 +366,9 @@ void VectorStore::load_from_disk(std::size_t N,
     clear();
     return;
   }
+  if (vectors.size() != N * dim_) {
+    throw std::runtime_error("VectorStore::load_from_disk: vectors size mismatch");
+  }
   if (alive.size() != N) {
     throw std::runtime_error("VectorStore::load_from_disk: alive size mismatch");
   }
@@ -197,26 +378,79 @@ void VectorStore::load_from_disk(std::size_t N,
   if (meta.size() != N) {
     throw std::runtime_error("VectorStore::load_from_disk: meta size mismatch");
   }
-  if (vectors.size() != N * dim_) {
+
+  if (half_rows()) {
+    std::vector<std::uint16_t> rows(N * dim_);
+    encode_half_row(format_, vectors.data(), N * dim_, rows.data());
+    load_from_disk(N, rows, alive, ids, meta);
+    return;
+  }
+
+  data_.clear();
+  data_.grow(N);
+  for (std::size_t i = 0; i < N; ++i) {
+    std::copy(vectors.begin() + i * dim_, vectors.begin() + (i + 1) * dim_, ptr_at_(i));
+  }
+  half_.clear();
+  finish_load_(alive, ids, meta);
+}
+
+void VectorStore::load_from_disk(std::size_t N,
+                                 const std::vector<std::uint16_t>& rows,
+                                 const std::vector<std::uint8_t>& alive,
+                                 const std::vector<std::string>& ids,
+                                 const std::vector<Metadata>& meta) {
+  if (!half_rows()) {
+    throw std::logic_error("VectorStore::load_from_disk: store does not keep half rows");
+  }
+  if (N == 0) {
+    clear();
+    return;
+  }
+  if (rows.size() != N * dim_) {
     throw std::runtime_error("VectorStore::load_from_disk: vectors size mismatch");
   }
+  if (alive.size() != N) {
+    throw std::runtime_error("VectorStore::load_from_disk: alive size mismatch");
+  }
+  if (ids.size() != N) {
+    throw std::runtime_error("VectorStore::load_from_disk: ids size mismatch");
+  }
+  if (meta.size() != N) {
+    throw std::runtime_error("VectorStore::load_from_disk: meta size mismatch");
+  }
 
-  ids_ = ids;
-  alive_ = alive;
-  data_ = vectors;
-  meta_ = meta;
+  half_.clear();
+  half_.grow(N);
+  for (std::size_t i = 0; i < N; ++i) {
+    std::copy(rows.begin() + i * dim_, rows.begin() + (i + 1) * dim_, half_.row(i));
+  }
+  data_.clear();
+  finish_load_(alive, ids, meta);
+}
 
-  id_to_index_.clear();
-  id_to_index_.reserve(N);
+void VectorStore::finish_load_(const std::vector<std::uint8_t>& alive,
+                               const std::vector<std::string>& ids,
+                               const std::vector<Metadata>& meta) {
+  const std::size_t N = half_rows() ? half_.rows() : data_.rows();
+  // Every non-empty id is mapped, dead or not, so a dead id can be revived;
+  // an empty id is a hole with no name.
+  ids_.assign(ids);
+  alive_.assign(alive);
+  meta_ = meta;
 
-  // Rebuild mapping:
-  // - If ids_[i] is non-empty, we map it to i (even if dead) so we can "revive".
-  // - If empty, skip (hole with no name).
+  std::vector<float> scratch(dim_);
+  inv_norms_.resize(N);
   for (std::size_t i = 0; i < N; ++i) {
-    if (!ids_[i].empty()) {
-      id_to_index_[ids_[i]] = i;
-    }
+    inv_norms_[i] = Distance::inv_norm(row_f32(i, scratch.data()), dim_);
   }
+
+  // SQ8 and binary codes are not persisted; rebuild them from the loaded
+  // rows. PQ codes are restored separately (restore_pq()), so drop any stale
+  // ones here.
+  if (has_sq8()) enable_sq8();
+  if (has_binary_) enable_binary();
+  disable_pq();
 }
 
 }  // namespace vecdb
@@ -3,37 +3,80 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+#include "AlignedAllocator.h"
+#include "AliveBitset.h"
+#include "BinaryQuantizer.h"
+#include "Half.h"
+#include "IdIndex.h"
 #include "Metadata.h"
+#include "ProductQuantizer.h"
+#include "RowBlocks.h"
+#include "ScalarQuantizer.h"
+#include "VectorView.h"
 
 namespace vecdb {
 
-// VectorStore: contiguous in-memory storage for fixed-dimension vectors.
+// VectorStore: in-memory storage for fixed-dimension vectors.
 // - Index is stable (0..N-1). Deletion creates "dead" slots but keeps indices.
-// - We maintain id <-> index mapping.
+// - Rows live in fixed-size blocks (RowBlocks) that never move, so appends
+//   do not copy existing rows and row pointers stay valid across inserts.
+// - F32 rows start on a cache line; with pad_rows each row is also padded
+//   with zeros to row_stride() floats, so every row is line-aligned.
+// - We maintain id <-> index mapping (IdIndex: one string arena plus an
+//   open-addressing hash, no allocation per id).
 // - This design is critical for persistence + HNSW graph correctness, because
 //   HNSW neighbor lists store indices.
 class VectorStore {
  public:
-  explicit VectorStore(std::size_t dim);
+  // pad_rows requires F32 rows (std::invalid_argument otherwise).
+  explicit VectorStore(std::size_t dim, RowFormat format = RowFormat::F32,
+                       bool pad_rows = false);
 
   // Fixed vector dimension for this store.
   std::size_t dim() const { return dim_; }
 
+  // Element type the rows are kept in (fixed at construction). With F16 /
+  // BF16 rows take half the memory, and the float accessors (get_ptr,
+  // get_mut_ptr, row_ptr) are unavailable: read rows through half_row_ptr()
+  // with a Distance::resolve_half() kernel, or widen them with row_f32().
+  RowFormat row_format() const { return format_; }
+  bool half_rows() const { return format_ != RowFormat::F32; }
+
+  // Distance between consecutive float rows: dim() rounded up to kRowPad
+  // when padded_rows(), else dim(). The padding floats are always zero, so
+  // kernels may run over row_stride() elements (Distance::resolve_aligned)
+  // as long as the query is padded the same way (aligned_query()).
+  std::size_t row_stride() const { return stride_; }
+  bool padded_rows() const { return pad_rows_; }
+
+  // Query in the row layout: query itself when rows are unpadded, otherwise
+  // a copy in buf (row_stride() floats, zero tail, line-aligned).
+  const float* aligned_query(const float* query, AlignedVector<float>& buf) const;
+
   // Number of slots (including dead slots). Indices range: [0, size()).
   std::size_t size() const { return ids_.size(); }
 
   // True if index exists and is alive.
   bool is_alive(std::size_t index) const;
 
+  // Number of alive slots, maintained on every write (O(1)).
+  std::size_t alive_count() const { return alive_.live_count(); }
+
+  // Alive flags, for scans: alive().for_each(begin, end, f) visits only the
+  // live slots of a range, skipping dead ones a word at a time.
+  const AliveBitset& alive() const { return alive_; }
+
   // Check whether an id exists AND is alive.
   bool contains(const std::string& id) const;
 
   // Return id string stored at an index (may be empty for dead slots).
+  // The view points into the id arena and is invalidated by the next
+  // insert/upsert/clear/load; copy it to keep it.
   // Precondition: index < size()
-  const std::string& id_at(std::size_t index) const;
+  std::string_view id_at(std::size_t index) const;
 
   // Return metadata for a slot (may be empty for dead slots).
   // Precondition: index < size()
@@ -44,9 +87,86 @@ class VectorStore {
 
   // Get pointer to vector data by index.
   // Returns nullptr if index out of range OR slot is dead.
+  // The pointer stays valid across later inserts/upserts (until clear() or
+  // load_from_disk()); an upsert of the same slot rewrites it in place.
+  // Throws std::logic_error if half_rows().
   const float* get_ptr(std::size_t index) const;
   float* get_mut_ptr(std::size_t index);
 
+  // Cached 1/||v|| for a slot (0 for a zero vector), kept in sync on
+  // insert/upsert/load so COSINE search does not recompute norms.
+  // Returns 1 without touching the cache when unit_norm() is set.
+  // Precondition: index < size(). Writes through get_mut_ptr() are not tracked.
+  float inv_norm(std::size_t index) const { return unit_norm_ ? 1.0f : inv_norms_[index]; }
+
+  // Declares that every row is already L2-normalized by the caller
+  // (Collection::Options::normalize). COSINE then reduces to 1 - dot.
+  void set_unit_norm(bool on) { unit_norm_ = on; }
+  bool unit_norm() const { return unit_norm_; }
+
+  // Unchecked row access for hot loops that already validated the slot
+  // (e.g. via is_alive()). Precondition: !half_rows() && index < size().
+  const float* row_ptr(std::size_t index) const { return data_.row(index); }
+
+  // Unchecked half row access. Precondition: half_rows() && index < size().
+  const std::uint16_t* half_row_ptr(std::size_t index) const {
+    return half_.row(index);
+  }
+
+  // Row as floats in any format: row_ptr(index) for F32; otherwise the row
+  // is widened into scratch (dim floats), which is returned.
+  // Precondition: index < size().
+  const float* row_f32(std::size_t index, float* scratch) const;
+
+  // -------- SQ8 codes (optional) --------
+  //
+  // enable_sq8() trains a ScalarQuantizer on the alive rows and keeps a
+  // dim-byte code per slot next to the float row (4x smaller than the row).
+  // Later inserts/upserts are encoded as they land, clamped to the trained
+  // range; calling enable_sq8() again retrains on the current data.
+  void enable_sq8();
+  void disable_sq8();
+  bool has_sq8() const { return sq8_.trained(); }
+  const ScalarQuantizer& sq8() const { return sq8_; }
+
+  // Precondition: has_sq8() && index < size().
+  const std::uint8_t* sq8_code(std::size_t index) const {
+    return sq8_codes_.data() + index * dim_;
+  }
+
+  // -------- PQ codes (optional) --------
+  //
+  // enable_pq(m) trains a ProductQuantizer with m subspaces on the alive rows
+  // and keeps an m-byte code per slot. Like SQ8, later writes are encoded as
+  // they land; unlike SQ8 the codebooks are persisted (pq.bin) because
+  // k-means is too slow to rerun on every open. restore_pq() installs a
+  // quantizer and codes read from disk.
+  void enable_pq(std::size_t m);
+  void disable_pq();
+  void restore_pq(ProductQuantizer pq, std::vector<std::uint8_t> codes);
+  bool has_pq() const { return pq_.trained(); }
+  const ProductQuantizer& pq() const { return pq_; }
+
+  // Precondition: has_pq() && index < size().
+  const std::uint8_t* pq_code(std::size_t index) const {
+    return pq_codes_.data() + index * pq_.m();
+  }
+
+  // -------- Binary codes (optional) --------
+  //
+  // enable_binary() keeps a packed sign-bit code per slot (dim/8 bytes,
+  // BinaryQuantizer::words() words). Nothing is trained, so codes are cheap
+  // to rebuild and are not persisted; later writes are encoded as they land.
+  void enable_binary();
+  void disable_binary();
+  bool has_binary() const { return has_binary_; }
+  const BinaryQuantizer& binary() const { return binary_; }
+
+  // Precondition: has_binary() && index < size().
+  const std::uint64_t* binary_code(std::size_t index) const {
+    return binary_codes_.data() + index * binary_.words();
+  }
+
   // Get pointer to vector data by id (alive only).
   // Returns nullptr if id not found or dead.
   const float* get_ptr(const std::string& id) const;
@@ -55,18 +175,31 @@ class VectorStore {
   // Insert a new (id, vec).
   // - If id already exists and alive: throws.
   // - If id exists but is dead: revives at same index (treated like upsert).
-  // Returns the index used.
+  // Returns the index used. vec is copied into the store; meta is taken by
+  // value, so callers can std::move() it in.
   std::size_t insert(const std::string& id,
-                     const std::vector<float>& vec,
-                     const Metadata& meta = Metadata{});
+                     VectorView vec,
+                     Metadata meta = Metadata{});
 
   // Upsert (insert or overwrite):
   // - If id exists and alive: overwrite vector in-place, return its index.
   // - If id exists but dead: revive at same index, overwrite vector, return index.
   // - Else: append a new slot, return new index.
   std::size_t upsert(const std::string& id,
-                     const std::vector<float>& vec,
-                     const Metadata& meta = Metadata{});
+                     VectorView vec,
+                     Metadata meta = Metadata{});
+
+  // Upsert ids.size() rows in order, each with upsert() semantics (a repeated
+  // id ends up with its last row). vectors holds the rows back to back
+  // (ids.size() * dim floats); meta is empty or has one entry per id. All
+  // inputs are validated before anything is written, and capacity for the
+  // new slots is reserved once instead of growing row by row.
+  void upsert_batch(const std::vector<std::string>& ids,
+                    VectorView vectors,
+                    std::vector<Metadata> meta = {});
+
+  // Pre-allocates room for n slots in every per-slot array.
+  void reserve(std::size_t n);
 
   // Remove by id:
   // - If id not found or already dead: returns false.
@@ -86,38 +219,91 @@ class VectorStore {
   // This MUST preserve indices:
   // - ids[i] is the id for slot i (may be empty if dead)
   // - alive[i] is 1/0 per slot
-  // - vectors is a flat array of length N*dim in row-major order
+  // - vectors is a flat array of length N*dim in row-major order (logical
+  //   layout; padded stores spread it out to row_stride())
   // - meta[i] is metadata for slot i (may be empty)
   //
   // After this, id->index mapping is rebuilt for alive slots.
+  //
+  // Float vectors are rounded on the way in if the store keeps half rows.
   void load_from_disk(std::size_t N,
                       const std::vector<float>& vectors,
                       const std::vector<std::uint8_t>& alive,
                       const std::vector<std::string>& ids,
                       const std::vector<Metadata>& meta);
 
+  // Same, with rows already in the store's half format (N*dim values).
+  // Precondition: half_rows().
+  void load_from_disk(std::size_t N,
+                      const std::vector<std::uint16_t>& rows,
+                      const std::vector<std::uint8_t>& alive,
+                      const std::vector<std::string>& ids,
+                      const std::vector<Metadata>& meta);
+
  private:
-  void validate_dim_(const std::vector<float>& vec) const;
+  void validate_dim_(VectorView vec) const;
+
+  // upsert() after validation: overwrite / revive / append one row.
+  std::size_t upsert_row_(const std::string& id, const float* vec, Metadata&& meta);
+
+  // Stores v into an existing slot (rounding it for half formats), then
+  // refreshes its cached norm and codes.
+  void write_row_(std::size_t index, const float* v);
+
+  // Refreshes the SQ8 / PQ / binary codes of a slot from its row as floats
+  // (each a no-op unless enabled).
+  void encode_codes_(std::size_t index, const float* row);
+
+  // Float pointers to every alive row, for training quantizers. Half rows are
+  // widened into decoded, which must outlive the result.
+  std::vector<const float*> alive_rows_f32_(std::vector<float>& decoded) const;
+
+  // Shared tail of both load_from_disk() overloads, once the rows are set.
+  // Only commits: the callers validate every size before touching the store.
+  void finish_load_(const std::vector<std::uint8_t>& alive,
+                    const std::vector<std::string>& ids,
+                    const std::vector<Metadata>& meta);
 
   float* ptr_at_(std::size_t index);
   const float* ptr_at_(std::size_t index) const;
 
   std::size_t dim_ = 0;
+  std::size_t stride_ = 0;
+  bool pad_rows_ = false;
+  RowFormat format_ = RowFormat::F32;
+  bool unit_norm_ = false;
+
+  // Rows of stride_ floats, each block starting on a cache line (F32 only).
+  RowBlocks<float> data_;
+
+  // Rows of dim_ 16-bit elements (F16 / BF16 only).
+  RowBlocks<std::uint16_t> half_;
 
-  // Flat array: [v0_dim floats][v1_dim floats]...
-  std::vector<float> data_;
+  // Index -> 1/||v|| (see inv_norm()).
+  std::vector<float> inv_norms_;
 
-  // Slot status (1 = alive, 0 = dead).
-  std::vector<std::uint8_t> alive_;
+  // SQ8 quantizer and flat codes, dim bytes per slot (see enable_sq8()).
+  ScalarQuantizer sq8_;
+  std::vector<std::uint8_t> sq8_codes_;
 
-  // Index -> id (empty string allowed for dead slot).
-  std::vector<std::string> ids_;
+  // PQ quantizer and flat codes, pq_.m() bytes per slot (see enable_pq()).
+  ProductQuantizer pq_;
+  std::vector<std::uint8_t> pq_codes_;
+
+  // Sign-bit codes, binary_.words() words per slot (see enable_binary()).
+  bool has_binary_ = false;
+  BinaryQuantizer binary_;
+  std::vector<std::uint64_t> binary_codes_;
+
+  // Slot status, one bit per slot (set = alive).
+  AliveBitset alive_;
+
+  // Index -> id (empty allowed for a dead slot) and id -> index. Dead ids
+  // stay mapped so an upsert can revive them in place (see remove()).
+  IdIndex ids_;
 
   // Index -> metadata (empty for dead slot).
   std::vector<Metadata> meta_;
-
-  // id -> index (only for alive ids)
-  std::unordered_map<std::string, std::size_t> id_to_index_;
 };
 
 }  // namespace vecdb
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+
+namespace vecdb {
+
+// Non-owning, read-only view of a float vector: pointer + length. Every API
+// that only reads a vector (insert/upsert, search) takes one, so callers
+// holding rows in mmap'd files, Arrow columns or network frames pass them
+// without first copying into a std::vector. Converts implicitly from
+// std::vector<float> and from a braced list (the latter only lives until the
+// end of the full expression, so use it for call arguments only).
+class VectorView {
+ public:
+  constexpr VectorView() noexcept = default;
+  constexpr VectorView(const float* data, std::size_t size) noexcept : data_(data), size_(size) {}
+  VectorView(const std::vector<float>& v) noexcept : data_(v.data()), size_(v.size()) {}
+  constexpr VectorView(std::initializer_list<float> il) noexcept
+      : data_(std::data(il)), size_(il.size()) {}
+
+  constexpr const float* data() const noexcept { return data_; }
+  constexpr std::size_t size() const noexcept { return size_; }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+
+  constexpr const float* begin() const noexcept { return data_; }
+  constexpr const float* end() const noexcept { return data_ + size_; }
+  constexpr float operator[](std::size_t i) const noexcept { return data_[i]; }
+
+ private:
+  const float* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace vecdb
@@ -10,7 +10,8 @@ namespace vecdb {
 // mark[i] == stamp  => visited in current search
 // This avoids unordered_set and is cache-friendly.
 //
-// NOTE: Not thread-safe. (MVP: single-thread search)
+// NOTE: Not thread-safe. Concurrent searches each need their own (Hnsw keeps
+// one per in-flight search in its SearchContext pool).
 class Visited {
  public:
   Visited() = default;
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <iostream>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <atomic>
 #include <thread>
@@ -11,12 +12,19 @@
 #include <vector>
 #include <algorithm>
 
+#include "vecdb/AliveBitset.h"
 #include "vecdb/Distance.h"
+#include "vecdb/DistanceSimd.h"
+#include "vecdb/Eval.h"
 #include "vecdb/VectorStore.h"
+#include "vecdb/BinaryQuantizer.h"
 #include "vecdb/Bruteforce.h"
 #include "vecdb/Hnsw.h"
+#include "vecdb/IdIndex.h"
 #include "vecdb/Collection.h"
 #include "vecdb/Metadata.h"
+#include "vecdb/ProductQuantizer.h"
+#include "vecdb/Serializer.h"
 
 // ---------------- Minimal test macros ----------------
 static int g_failures = 0;
@@ -133,6 +141,136 @@ TEST_CASE(test_distance_sanity) {
   REQUIRE_NEAR(x[1], 0.8, 1e-6);
 }
 
+TEST_CASE(test_distance_simd_matches_scalar) {
+  namespace simd = vecdb::simd;
+  std::mt19937 rng(7);
+  const auto& ref = simd::kernels(simd::Level::Scalar);
+  const int top = static_cast<int>(simd::detect());
+
+  // Cover every tail length around the 4/8/16/32-wide main loops.
+  std::vector<std::size_t> dims;
+  for (std::size_t d = 1; d <= 70; ++d) dims.push_back(d);
+  dims.push_back(768);
+
+  for (int lvl = 0; lvl <= top; ++lvl) {
+    const auto& k = simd::kernels(static_cast<simd::Level>(lvl));
+    for (std::size_t dim : dims) {
+      auto a = rand_vec(rng, dim);
+      auto b = rand_vec(rng, dim);
+      double tol = 1e-5 * (double)dim;
+      REQUIRE_NEAR(k.l2_sq(a.data(), b.data(), dim), ref.l2_sq(a.data(), b.data(), dim), tol);
+      REQUIRE_NEAR(k.dot(a.data(), b.data(), dim), ref.dot(a.data(), b.data(), dim), tol);
+    }
+  }
+}
+
+TEST_CASE(test_distance_l2_bounded_abandons) {
+  namespace simd = vecdb::simd;
+  std::mt19937 rng(8);
+  const int top = static_cast<int>(simd::detect());
+
+  for (int lvl = 0; lvl <= top; ++lvl) {
+    const auto& k = simd::kernels(static_cast<simd::Level>(lvl));
+    for (std::size_t dim : {5, 64, 100, 768}) {
+      auto a = rand_vec(rng, dim);
+      auto b = rand_vec(rng, dim);
+      float exact = k.l2_sq(a.data(), b.data(), dim);
+      double tol = 1e-5 * (double)dim;
+      // Bound not reached: exact distance.
+      REQUIRE_NEAR(k.l2_sq_bounded(a.data(), b.data(), dim, exact * 2.0f), exact, tol);
+      // Bound exceeded: anything above the bound (possibly a partial sum).
+      float bound = exact * 0.25f;
+      float d = k.l2_sq_bounded(a.data(), b.data(), dim, bound);
+      REQUIRE_TRUE(d > bound);
+      REQUIRE_TRUE(d <= exact + tol);
+
+      // Batch form: per row, exact below the bound, above it otherwise.
+      std::vector<std::vector<float>> rows;
+      std::vector<const float*> ptrs;
+      for (int j = 0; j < 7; ++j) rows.push_back(rand_vec(rng, dim));
+      for (const auto& r : rows) ptrs.push_back(r.data());
+      std::vector<float> out(rows.size());
+      bound = k.l2_sq(a.data(), ptrs[3], dim);
+      k.l2_batch_bounded(a.data(), ptrs.data(), ptrs.size(), dim, bound, out.data());
+      for (std::size_t j = 0; j < rows.size(); ++j) {
+        float e = k.l2_sq(a.data(), ptrs[j], dim);
+        if (e < bound - tol) REQUIRE_NEAR(out[j], e, tol);
+        if (e > bound + tol) REQUIRE_TRUE(out[j] > bound);
+      }
+    }
+  }
+  REQUIRE_TRUE(vecdb::Distance::resolve_bounded(vecdb::Metric::L2) != nullptr);
+  REQUIRE_TRUE(vecdb::Distance::resolve_bounded(vecdb::Metric::COSINE) == nullptr);
+}
+
+TEST_CASE(test_distance_fixed_dim_kernels) {
+  namespace simd = vecdb::simd;
+  std::mt19937 rng(9);
+  const auto& ref = simd::kernels(simd::Level::Scalar);
+  const int top = static_cast<int>(simd::detect());
+
+  for (int lvl = 0; lvl <= top; ++lvl) {
+    const auto& k = simd::kernels(static_cast<simd::Level>(lvl));
+    REQUIRE_TRUE(k.find_fixed(100) == nullptr);
+    for (std::size_t i = 0; i < simd::kNumFixedDims; ++i) {
+      const std::size_t dim = simd::kFixedDims[i];
+      const auto* f = k.find_fixed(dim);
+      REQUIRE_TRUE(f != nullptr);
+      REQUIRE_EQ(f->dim, dim);
+
+      auto a = rand_vec(rng, dim);
+      auto b = rand_vec(rng, dim);
+      double tol = 1e-5 * (double)dim;
+      REQUIRE_NEAR(f->l2_sq(a.data(), b.data(), dim), ref.l2_sq(a.data(), b.data(), dim), tol);
+      REQUIRE_NEAR(f->dot(a.data(), b.data(), dim), ref.dot(a.data(), b.data(), dim), tol);
+      REQUIRE_NEAR(f->cosine_dist(a.data(), b.data(), dim, 0.5f, 0.25f),
+                   1.0 - ref.dot(a.data(), b.data(), dim) * 0.125, tol);
+    }
+  }
+
+  // resolve() picks the specialization transparently.
+  auto a = rand_vec(rng, 768);
+  auto b = rand_vec(rng, 768);
+  auto fn = vecdb::Distance::resolve(vecdb::Metric::L2, 768);
+  REQUIRE_NEAR(fn(a.data(), b.data(), 768, 1.f, 1.f), vecdb::Distance::l2_sq(a.data(), b.data(), 768), 1e-3);
+}
+
+TEST_CASE(test_distance_batch_matches_single) {
+  namespace simd = vecdb::simd;
+  std::mt19937 rng(13);
+  const int top = static_cast<int>(simd::detect());
+
+  for (std::size_t dim : {std::size_t(7), std::size_t(37), std::size_t(128)}) {
+    const std::size_t n = 11;  // not a multiple of the 4-row kernel
+    auto q = rand_vec(rng, dim);
+    std::vector<std::vector<float>> data;
+    std::vector<const float*> rows;
+    std::vector<float> inv;
+    for (std::size_t i = 0; i < n; ++i) data.push_back(rand_vec(rng, dim));
+    for (std::size_t i = 0; i < n; ++i) {
+      rows.push_back(data[i].data());
+      inv.push_back(vecdb::Distance::inv_norm(data[i].data(), dim));
+    }
+    const float q_inv = vecdb::Distance::inv_norm(q.data(), dim);
+
+    for (int lvl = 0; lvl <= top; ++lvl) {
+      const auto& k = simd::kernels(static_cast<simd::Level>(lvl));
+      const auto* f = k.find_fixed(dim);
+      std::vector<float> l2(n), cs(n), cs_unit(n);
+      (f ? f->l2_batch : k.l2_batch)(q.data(), rows.data(), n, dim, 1.f, nullptr, l2.data());
+      (f ? f->cosine_batch : k.cosine_batch)(q.data(), rows.data(), n, dim, q_inv, inv.data(), cs.data());
+      k.cosine_batch(q.data(), rows.data(), n, dim, 1.f, nullptr, cs_unit.data());
+      for (std::size_t i = 0; i < n; ++i) {
+        const float* a = q.data();
+        const float* b = data[i].data();
+        REQUIRE_NEAR(l2[i], vecdb::Distance::l2_sq(a, b, dim), 1e-4);
+        REQUIRE_NEAR(cs[i], vecdb::Distance::cosine_distance(a, b, dim), 1e-5);
+        REQUIRE_NEAR(cs_unit[i], 1.0 - vecdb::Distance::dot(a, b, dim), 1e-4);
+      }
+    }
+  }
+}
+
 TEST_CASE(test_vectorstore_basic) {
   vecdb::VectorStore store(2);
 
@@ -163,6 +301,115 @@ TEST_CASE(test_vectorstore_basic) {
   REQUIRE_TRUE(store.get_ptr(i1) == nullptr);
 }
 
+TEST_CASE(test_id_index_arena_and_probing) {
+  vecdb::IdIndex ix;
+  REQUIRE_EQ(ix.size(), (std::size_t)0);
+  REQUIRE_EQ(ix.find("a"), vecdb::IdIndex::npos);
+
+  // Enough ids to force several rehashes; long ones exercise the arena.
+  const std::size_t n = 5000;
+  for (std::size_t i = 0; i < n; ++i) {
+    ix.append(i % 7 == 0 ? "a_rather_long_identifier_" + std::to_string(i) : std::to_string(i));
+  }
+  ix.append("");  // hole with no name
+  REQUIRE_EQ(ix.size(), n + 1);
+  REQUIRE_TRUE(ix.id(n).empty());
+  REQUIRE_EQ(ix.find(""), vecdb::IdIndex::npos);
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::string id = i % 7 == 0 ? "a_rather_long_identifier_" + std::to_string(i) : std::to_string(i);
+    REQUIRE_EQ(ix.find(id), i);
+    REQUIRE_TRUE(ix.id(i) == id);
+  }
+  REQUIRE_EQ(ix.find("missing"), vecdb::IdIndex::npos);
+
+  // A repeated id maps to its latest slot; the old slot keeps its name.
+  ix.append("8");
+  REQUIRE_EQ(ix.find("8"), n + 1);
+  REQUIRE_TRUE(ix.id(8) == "8");
+
+  ix.assign({"x", "", "y", "x"});
+  REQUIRE_EQ(ix.size(), (std::size_t)4);
+  REQUIRE_EQ(ix.find("x"), (std::size_t)3);
+  REQUIRE_EQ(ix.find("y"), (std::size_t)2);
+  REQUIRE_EQ(ix.find("0"), vecdb::IdIndex::npos);
+
+  ix.clear();
+  REQUIRE_EQ(ix.size(), (std::size_t)0);
+  REQUIRE_EQ(ix.find("x"), vecdb::IdIndex::npos);
+}
+
+TEST_CASE(test_alive_bitset_and_live_count) {
+  vecdb::AliveBitset bits;
+  const std::size_t n = 200;
+  for (std::size_t i = 0; i < n; ++i) bits.push_back(i % 3 == 0);
+  REQUIRE_EQ(bits.size(), n);
+  REQUIRE_EQ(bits.live_count(), (std::size_t)67);
+
+  bits.set(0);    // already set: count unchanged
+  bits.reset(1);  // already clear
+  bits.reset(63);
+  bits.set(64);
+  REQUIRE_EQ(bits.live_count(), (std::size_t)67);
+
+  // Ranges that start and end mid-word, span words, or are empty.
+  const std::pair<std::size_t, std::size_t> ranges[] = {{0, n}, {5, 70}, {64, 128}, {130, 131}, {7, 7}};
+  for (const auto& r : ranges) {
+    std::vector<std::size_t> got;
+    bits.for_each(r.first, r.second, [&](std::size_t i) { got.push_back(i); });
+    std::vector<std::size_t> want;
+    for (std::size_t i = r.first; i < r.second; ++i) {
+      if (bits.test(i)) want.push_back(i);
+    }
+    REQUIRE_TRUE(got == want);
+  }
+
+  // The store keeps its count through remove / revive / load.
+  vecdb::VectorStore store(2);
+  store.upsert("a", {1.f, 0.f});
+  store.upsert("b", {0.f, 1.f});
+  store.upsert("c", {1.f, 1.f});
+  REQUIRE_EQ(store.alive_count(), (std::size_t)3);
+  REQUIRE_TRUE(store.remove("b"));
+  REQUIRE_FALSE(store.remove("b"));
+  REQUIRE_EQ(store.alive_count(), (std::size_t)2);
+  store.upsert("b", {0.f, 2.f});
+  REQUIRE_EQ(store.alive_count(), (std::size_t)3);
+
+  store.load_from_disk(3, std::vector<float>(6, 1.f), {1, 0, 1}, {"a", "b", "c"},
+                       std::vector<vecdb::Metadata>(3));
+  REQUIRE_EQ(store.alive_count(), (std::size_t)2);
+  REQUIRE_FALSE(store.is_alive(1));
+
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  const auto res = bf.search({1.f, 1.f}, 3);
+  REQUIRE_EQ(res.size(), (std::size_t)2);
+}
+
+TEST_CASE(test_vectorstore_bad_load_leaves_store_unchanged) {
+  // A size mismatch is caught before any row is replaced.
+  for (auto fmt : {vecdb::RowFormat::F32, vecdb::RowFormat::F16}) {
+    vecdb::VectorStore store(2, fmt);
+    store.upsert("a", {1.f, 0.f});
+    store.upsert("b", {0.f, 1.f});
+    REQUIRE_TRUE(store.remove("b"));
+
+    bool threw = false;
+    try {
+      store.load_from_disk(3, std::vector<float>(6, 5.f), {1, 1, 1}, {"x", "y"},
+                           std::vector<vecdb::Metadata>(3));
+    } catch (const std::runtime_error&) {
+      threw = true;
+    }
+    REQUIRE_TRUE(threw);
+    REQUIRE_EQ(store.size(), (std::size_t)2);
+    REQUIRE_EQ(store.alive_count(), (std::size_t)1);
+    REQUIRE_TRUE(store.id_at(0) == "a");
+    REQUIRE_FALSE(store.is_alive(1));
+    float scratch[2];
+    REQUIRE_EQ(store.row_f32(0, scratch)[0], 1.f);
+  }
+}
+
 TEST_CASE(test_bruteforce_topk_matches_manual) {
   vecdb::VectorStore store(2);
   // points: (0,0), (1,0), (0,1)
@@ -182,6 +429,684 @@ TEST_CASE(test_bruteforce_topk_matches_manual) {
   REQUIRE_NEAR(top2[0].distance, 0.02, 1e-6);
 }
 
+TEST_CASE(test_cosine_uses_cached_norms) {
+  std::mt19937 rng(11);
+  const std::size_t dim = 24;
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < 200; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  // Overwrite must refresh the cached norm.
+  std::vector<float> big(dim, 5.f);
+  auto idx = store.upsert("id_3", big);
+  REQUIRE_NEAR(store.inv_norm(idx), 1.0 / vecdb::Distance::norm(big.data(), dim), 1e-6);
+
+  auto q = rand_vec(rng, dim);
+  vecdb::Bruteforce bf(store, vecdb::Metric::COSINE);
+  auto res = bf.search(q, 20);
+  REQUIRE_EQ(res.size(), (std::size_t)20);
+  for (const auto& r : res) {
+    float ref = vecdb::Distance::cosine_distance(q.data(), store.get_ptr(r.index), dim);
+    REQUIRE_NEAR(r.distance, ref, 1e-5);
+  }
+}
+
+TEST_CASE(test_sq8_codes_and_kernels) {
+  namespace simd = vecdb::simd;
+  std::mt19937 rng(21);
+  const std::size_t dim = 45;  // 16/32-wide loops plus a tail
+  std::vector<std::vector<float>> data;
+  std::vector<const float*> rows;
+  for (int i = 0; i < 200; ++i) data.push_back(rand_vec(rng, dim));
+  for (const auto& v : data) rows.push_back(v.data());
+
+  vecdb::ScalarQuantizer sq(dim);
+  sq.train(rows.data(), rows.size());
+  REQUIRE_TRUE(sq.trained());
+
+  std::vector<std::uint8_t> code(dim);
+  std::vector<float> back(dim);
+  sq.encode(rows[7], code.data());
+  sq.decode(code.data(), back.data());
+  for (std::size_t d = 0; d < dim; ++d) {
+    REQUIRE_NEAR(back[d], rows[7][d], sq.scale()[d] * 0.5 + 1e-6);
+  }
+
+  // Code distances equal float distances against the decoded row, at every level.
+  auto q = rand_vec(rng, dim);
+  const int top = static_cast<int>(simd::detect());
+  for (auto metric : {vecdb::Metric::L2, vecdb::Metric::COSINE, vecdb::Metric::IP}) {
+    const float q_inv = vecdb::Distance::inv_norm(q.data(), dim);
+    const float b_inv = vecdb::Distance::inv_norm(back.data(), dim);
+    auto pq = sq.prepare(metric, q.data(), q_inv);
+    float ref = vecdb::Distance::distance(metric, q.data(), back.data(), dim, q_inv, b_inv);
+    REQUIRE_NEAR(sq.distance(pq, code.data(), b_inv), ref, 1e-4);
+    for (int lvl = 0; lvl <= top; ++lvl) {
+      const auto& k = simd::kernels(static_cast<simd::Level>(lvl));
+      REQUIRE_NEAR(k.sq8_dot(pq.q.data(), code.data(), dim),
+                   simd::kernels(simd::Level::Scalar).sq8_dot(pq.q.data(), code.data(), dim), 1e-3);
+      REQUIRE_NEAR(k.sq8_l2(pq.q.data(), sq.scale().data(), code.data(), dim),
+                   simd::kernels(simd::Level::Scalar).sq8_l2(pq.q.data(), sq.scale().data(),
+                                                             code.data(), dim),
+                   1e-3);
+    }
+  }
+}
+
+TEST_CASE(test_hnsw_sq8_search_reranks_exactly) {
+  std::mt19937 rng(22);
+  const std::size_t dim = 32;
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < 2000; ++i) store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  store.enable_sq8();
+  // Written after training: encoded on upsert.
+  store.upsert("late", rand_vec(rng, dim));
+
+  vecdb::Hnsw hnsw(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < store.size(); ++i) hnsw.insert(i);
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+
+  double recall = 0.0;
+  const int queries = 30;
+  for (int qi = 0; qi < queries; ++qi) {
+    auto q = rand_vec(rng, dim);
+    auto approx = hnsw.search_quantized(q, 10, 100);
+    REQUIRE_EQ(approx.size(), (std::size_t)10);
+    for (const auto& r : approx) {
+      REQUIRE_NEAR(r.distance, vecdb::Distance::l2_sq(q.data(), store.get_ptr(r.index), dim), 1e-4);
+    }
+    recall += recall_at_k(to_indices(bf.search(q, 10)), to_indices(approx));
+  }
+  REQUIRE_TRUE(recall / queries > 0.9);
+
+  // Collection: option survives save/open, codes are retrained on open.
+  auto dir = make_temp_dir("sq8_collection");
+  vecdb::Collection::Options opt;
+  opt.dim = 4;
+  opt.sq8 = true;
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  col.upsert("u1", {1, 0, 0, 0});
+  col.upsert("u2", {0, 1, 0, 0});
+  col.upsert("u3", {0, 0, 1, 0});
+  col.build_index();
+  col.save();
+
+  auto col2 = vecdb::Collection::open(dir.string());
+  REQUIRE_TRUE(col2.quantized());
+  auto res = col2.search({0.9f, 0.1f, 0.f, 0.f}, 2, 50);
+  REQUIRE_EQ(col2.id_at(res[0].index), std::string("u1"));
+  REQUIRE_NEAR(res[0].distance, 0.02, 1e-6);
+}
+
+TEST_CASE(test_pq_codec_and_adc) {
+  std::mt19937 rng(23);
+  const std::size_t dim = 24;
+  std::vector<std::vector<float>> data;
+  std::vector<const float*> rows;
+  for (int i = 0; i < 100; ++i) data.push_back(rand_vec(rng, dim));
+  for (const auto& v : data) rows.push_back(v.data());
+
+  bool threw = false;
+  try {
+    vecdb::ProductQuantizer bad(dim, 5);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+
+  // Fewer rows than centroids: every row keeps its own centroid.
+  vecdb::ProductQuantizer pq(dim, 6);
+  pq.train(rows.data(), rows.size());
+  REQUIRE_TRUE(pq.trained());
+  REQUIRE_EQ(pq.dsub(), (std::size_t)4);
+  std::vector<std::uint8_t> code(pq.m());
+  std::vector<float> back(dim);
+  pq.encode(rows[11], code.data());
+  pq.decode(code.data(), back.data());
+  for (std::size_t d = 0; d < dim; ++d) REQUIRE_NEAR(back[d], rows[11][d], 1e-6);
+
+  // ADC equals the float distance against the decoded row.
+  auto q = rand_vec(rng, dim);
+  pq.encode(rows[42], code.data());
+  pq.decode(code.data(), back.data());
+  for (auto metric : {vecdb::Metric::L2, vecdb::Metric::COSINE, vecdb::Metric::IP}) {
+    const float q_inv = vecdb::Distance::inv_norm(q.data(), dim);
+    const float b_inv = vecdb::Distance::inv_norm(back.data(), dim);
+    auto t = pq.prepare(metric, q.data(), q_inv);
+    float ref = vecdb::Distance::distance(metric, q.data(), back.data(), dim, q_inv, b_inv);
+    REQUIRE_NEAR(pq.distance(t, code.data(), b_inv), ref, 1e-4);
+  }
+}
+
+TEST_CASE(test_pq_search_and_persistence) {
+  std::mt19937 rng(24);
+  const std::size_t dim = 32;
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < 2000; ++i) store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  store.enable_pq(8);
+  REQUIRE_TRUE(store.has_pq());
+  store.upsert("late", rand_vec(rng, dim));  // encoded on upsert
+
+  vecdb::Hnsw hnsw(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < store.size(); ++i) hnsw.insert(i);
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+
+  double bf_recall = 0.0, hnsw_recall = 0.0;
+  const int queries = 30;
+  for (int qi = 0; qi < queries; ++qi) {
+    auto q = rand_vec(rng, dim);
+    auto truth = to_indices(bf.search(q, 10));
+    auto scan = bf.search_pq(q, 10, /*rerank=*/100);
+    REQUIRE_EQ(scan.size(), (std::size_t)10);
+    for (const auto& r : scan) {
+      REQUIRE_NEAR(r.distance, vecdb::Distance::l2_sq(q.data(), store.get_ptr(r.index), dim), 1e-4);
+    }
+    bf_recall += recall_at_k(truth, to_indices(scan));
+    hnsw_recall += recall_at_k(truth, to_indices(hnsw.search_pq(q, 10, 100)));
+  }
+  REQUIRE_TRUE(bf_recall / queries > 0.9);
+  REQUIRE_TRUE(hnsw_recall / queries > 0.8);
+
+  // Collection: codebooks and codes round-trip through pq.bin.
+  auto dir = make_temp_dir("pq_collection");
+  vecdb::Collection::Options opt;
+  opt.dim = dim;
+  opt.pq_m = 8;
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  for (std::size_t i = 0; i < 300; ++i) col.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  col.build_index();
+  col.save();
+  REQUIRE_TRUE(std::filesystem::exists(dir / "pq.bin"));
+
+  vecdb::VectorStore loaded(dim);
+  vecdb::Serializer::load_store(dir.string(), loaded);
+  REQUIRE_TRUE(loaded.has_pq());
+  REQUIRE_EQ(loaded.pq().m(), (std::size_t)8);
+
+  auto col2 = vecdb::Collection::open(dir.string());
+  REQUIRE_EQ(col2.pq_subspaces(), (std::size_t)8);
+  auto q = rand_vec(rng, dim);
+  auto a = col.search(q, 5, 50);
+  auto b = col2.search(q, 5, 50);
+  REQUIRE_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) REQUIRE_EQ(a[i].index, b[i].index);
+}
+
+TEST_CASE(test_binary_hamming_prefilter) {
+  std::mt19937 rng(25);
+
+  // Kernel: every active level agrees with a bit-by-bit count.
+  const std::size_t dim = 200;  // not a multiple of 64: last word is padded
+  vecdb::BinaryQuantizer bq(dim);
+  REQUIRE_EQ(bq.words(), (std::size_t)4);
+  auto a = rand_vec(rng, dim);
+  auto b = rand_vec(rng, dim);
+  std::vector<std::uint64_t> ca(bq.words()), cb(bq.words());
+  bq.encode(a.data(), ca.data());
+  bq.encode(b.data(), cb.data());
+  std::uint32_t expect = 0;
+  for (std::size_t d = 0; d < dim; ++d) expect += (a[d] > 0.0f) != (b[d] > 0.0f);
+  REQUIRE_EQ(bq.hamming(ca.data(), cb.data()), expect);
+  for (int lvl = 0; lvl <= static_cast<int>(vecdb::simd::detect()); ++lvl) {
+    const auto& k = vecdb::simd::kernels(static_cast<vecdb::simd::Level>(lvl));
+    REQUIRE_EQ(k.hamming(ca.data(), cb.data(), bq.words()), expect);
+  }
+
+  // Collection: the Hamming shortlist is reranked with exact cosine.
+  const std::size_t cdim = 64;
+  auto dir = make_temp_dir("binary_collection");
+  vecdb::Collection::Options opt;
+  opt.dim = cdim;
+  opt.metric = vecdb::Metric::COSINE;
+  opt.binary_shortlist = 200;
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  for (std::size_t i = 0; i < 2000; ++i) col.upsert("id_" + std::to_string(i), rand_vec(rng, cdim));
+  REQUIRE_TRUE(!col.has_index());
+  col.save();
+
+  auto col2 = vecdb::Collection::open(dir.string());
+  REQUIRE_EQ(col2.binary_shortlist(), (std::size_t)200);
+
+  vecdb::VectorStore store(cdim);
+  vecdb::Serializer::load_store(dir.string(), store);
+  vecdb::Bruteforce bf(store, vecdb::Metric::COSINE);
+
+  double recall = 0.0;
+  const int queries = 20;
+  for (int qi = 0; qi < queries; ++qi) {
+    auto q = rand_vec(rng, cdim);
+    auto res = col2.search(q, 10, 0);
+    REQUIRE_EQ(res.size(), (std::size_t)10);
+    for (const auto& r : res) {
+      REQUIRE_NEAR(r.distance,
+                   vecdb::Distance::cosine_distance(q.data(), store.get_ptr(r.index), cdim), 1e-5);
+    }
+    recall += recall_at_k(to_indices(bf.search(q, 10)), to_indices(res));
+  }
+  REQUIRE_TRUE(recall / queries > 0.8);
+
+  bool threw = false;
+  try {
+    bf.search_binary(rand_vec(rng, cdim), 10, 100);
+  } catch (const std::logic_error&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+}
+
+TEST_CASE(test_half_conversions) {
+  // Exact values survive; others round to nearest even.
+  for (float v : {0.0f, 1.0f, -2.5f, 65504.0f, 6.103515625e-05f, 5.9604645e-08f}) {
+    REQUIRE_EQ(vecdb::f16_to_float(vecdb::float_to_f16(v)), v);
+  }
+  REQUIRE_EQ(vecdb::float_to_f16(1.0f + 1.0f / 2048.0f), (std::uint16_t)0x3C00);  // tie -> even
+  REQUIRE_EQ(vecdb::float_to_f16(1.0f + 3.0f / 2048.0f), (std::uint16_t)0x3C02);
+  REQUIRE_TRUE(std::isinf(vecdb::f16_to_float(vecdb::float_to_f16(70000.0f))));
+  REQUIRE_EQ(vecdb::bf16_to_float(vecdb::float_to_bf16(-3.0f)), -3.0f);
+  REQUIRE_EQ(vecdb::float_to_bf16(1.0f + 1.0f / 256.0f), (std::uint16_t)0x3F80);  // tie -> even
+
+  // Every SIMD level matches float math on the widened row.
+  std::mt19937 rng(26);
+  for (std::size_t dim : {7u, 33u, 100u}) {
+    auto q = rand_vec(rng, dim);
+    auto x = rand_vec(rng, dim);
+    for (auto fmt : {vecdb::RowFormat::F16, vecdb::RowFormat::BF16}) {
+      std::vector<std::uint16_t> h(dim);
+      std::vector<float> w(dim);
+      vecdb::encode_half_row(fmt, x.data(), dim, h.data());
+      vecdb::decode_half_row(fmt, h.data(), dim, w.data());
+      const float q_inv = vecdb::Distance::inv_norm(q.data(), dim);
+      const float w_inv = vecdb::Distance::inv_norm(w.data(), dim);
+      for (int lvl = 0; lvl <= static_cast<int>(vecdb::simd::detect()); ++lvl) {
+        const auto& k = vecdb::simd::kernels(static_cast<vecdb::simd::Level>(lvl));
+        const auto& hk = fmt == vecdb::RowFormat::F16 ? k.f16 : k.bf16;
+        REQUIRE_NEAR(hk.l2_dist(q.data(), h.data(), dim, q_inv, w_inv),
+                     vecdb::Distance::l2_sq(q.data(), w.data(), dim), 1e-4);
+        REQUIRE_NEAR(hk.cosine_dist(q.data(), h.data(), dim, q_inv, w_inv),
+                     vecdb::Distance::cosine_distance(q.data(), w.data(), dim, q_inv, w_inv), 1e-5);
+        REQUIRE_NEAR(hk.ip_dist(q.data(), h.data(), dim, q_inv, w_inv),
+                     vecdb::Distance::ip_distance(q.data(), w.data(), dim), 1e-4);
+      }
+    }
+  }
+}
+
+TEST_CASE(test_half_row_collection) {
+  std::mt19937 rng(27);
+  const std::size_t dim = 48;
+  std::vector<std::vector<float>> data;
+  for (std::size_t i = 0; i < 1500; ++i) data.push_back(rand_vec(rng, dim));
+
+  vecdb::VectorStore ref(dim);
+  for (std::size_t i = 0; i < data.size(); ++i) ref.upsert("id_" + std::to_string(i), data[i]);
+  vecdb::Bruteforce ref_bf(ref, vecdb::Metric::COSINE);
+
+  for (auto fmt : {vecdb::RowFormat::F16, vecdb::RowFormat::BF16}) {
+    auto dir = make_temp_dir(std::string("half_") + vecdb::row_format_to_string(fmt));
+    vecdb::Collection::Options opt;
+    opt.dim = dim;
+    opt.metric = vecdb::Metric::COSINE;
+    opt.row_format = fmt;
+    auto col = vecdb::Collection::create(dir.string(), opt);
+    for (std::size_t i = 0; i < data.size(); ++i) col.upsert("id_" + std::to_string(i), data[i]);
+    col.remove("id_3");
+    col.build_index();
+    col.save();
+
+    // Two bytes per element on disk (plus the 32-byte header).
+    REQUIRE_EQ(std::filesystem::file_size(dir / "vectors.bin"),
+               (std::uintmax_t)(32 + data.size() * dim * 2));
+
+    auto col2 = vecdb::Collection::open(dir.string());
+    REQUIRE_TRUE(col2.row_format() == fmt);
+    REQUIRE_TRUE(!col2.contains("id_3"));
+
+    double recall = 0.0;
+    const int queries = 20;
+    for (int qi = 0; qi < queries; ++qi) {
+      auto q = rand_vec(rng, dim);
+      auto truth = to_indices(ref_bf.search(q, 10));
+      truth.erase(std::remove(truth.begin(), truth.end(), (std::size_t)3), truth.end());
+      auto got = to_indices(col2.search(q, 10, 100));
+      recall += recall_at_k(truth, got);
+    }
+    REQUIRE_TRUE(recall / queries > 0.85);
+
+    // Filtered scan and an F32 store loading the half file agree on distances.
+    vecdb::VectorStore widened(dim);
+    vecdb::Serializer::load_store(dir.string(), widened);
+    auto q = rand_vec(rng, dim);
+    auto res = col2.search(q, 5, 100, vecdb::Collection::MetadataFilter{});
+    vecdb::Bruteforce wbf(widened, vecdb::Metric::COSINE);
+    auto exact = wbf.search(q, 5);
+    REQUIRE_EQ(res.size(), exact.size());
+    for (std::size_t i = 0; i < res.size(); ++i) REQUIRE_NEAR(res[i].distance, exact[i].distance, 1e-5);
+  }
+}
+
+TEST_CASE(test_padded_rows) {
+  std::mt19937 rng(28);
+
+  // Aligned kernels agree with the generic ones at every level.
+  for (std::size_t dim : {16u, 48u, 112u, 208u}) {
+    vecdb::AlignedVector<float> a(dim), b(dim);
+    for (std::size_t i = 0; i < dim; ++i) {
+      a[i] = std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+      b[i] = std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+    }
+    const float ia = vecdb::Distance::inv_norm(a.data(), dim);
+    const float ib = vecdb::Distance::inv_norm(b.data(), dim);
+    for (int lvl = 0; lvl <= static_cast<int>(vecdb::simd::detect()); ++lvl) {
+      const auto& al = vecdb::simd::kernels(static_cast<vecdb::simd::Level>(lvl)).aligned;
+      REQUIRE_NEAR(al.l2_dist(a.data(), b.data(), dim, ia, ib),
+                   vecdb::Distance::l2_sq(a.data(), b.data(), dim), 1e-4);
+      REQUIRE_NEAR(al.cosine_dist(a.data(), b.data(), dim, ia, ib),
+                   vecdb::Distance::cosine_distance(a.data(), b.data(), dim, ia, ib), 1e-5);
+      REQUIRE_NEAR(al.ip_dist(a.data(), b.data(), dim, ia, ib),
+                   vecdb::Distance::ip_distance(a.data(), b.data(), dim), 1e-4);
+    }
+  }
+
+  bool threw = false;
+  try {
+    vecdb::VectorStore bad(8, vecdb::RowFormat::F16, true);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+
+  // 120 pads to 128, a fixed-kernel dim; 100 pads to 112 and uses the
+  // aligned kernels.
+  for (std::size_t dim : {100u, 120u}) {
+    std::vector<std::vector<float>> data;
+    for (std::size_t i = 0; i < 800; ++i) data.push_back(rand_vec(rng, dim));
+
+    auto dir = make_temp_dir("padded_" + std::to_string(dim));
+    vecdb::Collection::Options opt;
+    opt.dim = dim;
+    opt.metric = vecdb::Metric::COSINE;
+    opt.pad_rows = true;
+    auto col = vecdb::Collection::create(dir.string(), opt);
+    vecdb::VectorStore ref(dim);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+      col.upsert("id_" + std::to_string(i), data[i]);
+      ref.upsert("id_" + std::to_string(i), data[i]);
+    }
+    col.remove("id_5");
+    ref.remove("id_5");
+    col.build_index();
+    col.save();
+
+    // vectors.bin keeps the logical layout (24-byte header, dim floats per row).
+    REQUIRE_EQ(std::filesystem::file_size(dir / "vectors.bin"),
+               (std::uintmax_t)(24 + data.size() * dim * sizeof(float)));
+
+    auto col2 = vecdb::Collection::open(dir.string());
+    REQUIRE_TRUE(col2.padded_rows());
+
+    vecdb::VectorStore padded(dim, vecdb::RowFormat::F32, true);
+    vecdb::Serializer::load_store(dir.string(), padded);
+    REQUIRE_EQ(padded.row_stride(), (std::size_t)((dim + 15) / 16 * 16));
+    for (std::size_t i = 0; i < padded.size(); ++i) {
+      REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(padded.row_ptr(i)) % vecdb::kCacheLine,
+                 (std::uintptr_t)0);
+      for (std::size_t d = dim; d < padded.row_stride(); ++d) REQUIRE_EQ(padded.row_ptr(i)[d], 0.0f);
+    }
+
+    vecdb::Bruteforce bf(padded, vecdb::Metric::COSINE);
+    vecdb::Bruteforce ref_bf(ref, vecdb::Metric::COSINE);
+    double recall = 0.0;
+    const int queries = 20;
+    for (int qi = 0; qi < queries; ++qi) {
+      auto q = rand_vec(rng, dim);
+      auto truth = ref_bf.search(q, 10);
+      auto got = bf.search(q, 10);
+      REQUIRE_EQ(got.size(), truth.size());
+      for (std::size_t j = 0; j < got.size(); ++j) {
+        REQUIRE_EQ(got[j].index, truth[j].index);
+        REQUIRE_NEAR(got[j].distance, truth[j].distance, 1e-5);
+      }
+      recall += recall_at_k(to_indices(truth), to_indices(col2.search(q, 10, 100)));
+
+      auto filtered = col2.search(q, 3, 100, vecdb::Collection::MetadataFilter{});
+      for (std::size_t j = 0; j < filtered.size(); ++j) {
+        REQUIRE_NEAR(filtered[j].distance, truth[j].distance, 1e-5);
+      }
+    }
+    REQUIRE_TRUE(recall / queries > 0.9);
+  }
+}
+
+TEST_CASE(test_store_row_pointers_stable_across_growth) {
+  std::mt19937 rng(29);
+  const std::size_t dim = 20;
+  vecdb::VectorStore store(dim, vecdb::RowFormat::F32, /*pad_rows=*/true);
+  vecdb::VectorStore half(dim, vecdb::RowFormat::BF16);
+
+  auto first = rand_vec(rng, dim);
+  store.insert("a", first);
+  half.insert("a", first);
+  const float* p0 = store.get_ptr("a");
+  const std::uint16_t* h0 = half.half_row_ptr(0);
+
+  // Several blocks' worth of appends must not move row 0.
+  for (std::size_t i = 0; i < 3 * vecdb::RowBlocks<float>::kRowsPerBlock + 7; ++i) {
+    auto v = rand_vec(rng, dim);
+    store.upsert("v" + std::to_string(i), v);
+    half.upsert("v" + std::to_string(i), v);
+  }
+  REQUIRE_TRUE(store.get_ptr("a") == p0);
+  REQUIRE_TRUE(half.half_row_ptr(0) == h0);
+  for (std::size_t d = 0; d < dim; ++d) REQUIRE_EQ(p0[d], first[d]);
+
+  // Rows in later blocks are still line-aligned and readable.
+  const std::size_t last = store.size() - 1;
+  REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(store.row_ptr(last)) % vecdb::kCacheLine,
+             (std::uintptr_t)0);
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  auto self = bf.search(std::vector<float>(store.row_ptr(last), store.row_ptr(last) + dim), 1);
+  REQUIRE_EQ(self.size(), (std::size_t)1);
+  REQUIRE_EQ(self[0].index, last);
+}
+
+TEST_CASE(test_upsert_batch_matches_upsert) {
+  std::mt19937 rng(30);
+  const std::size_t dim = 12;
+  auto dir = make_temp_dir("upsert_batch");
+  vecdb::Collection::Options opt;
+  opt.dim = dim;
+  opt.metric = vecdb::Metric::COSINE;
+  opt.normalize = true;
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  auto ref = vecdb::Collection::create((dir / "ref").string(), opt);
+
+  col.upsert("old", rand_vec(rng, dim));
+  ref.upsert("old", rand_vec(rng, dim));
+  col.remove("old");
+  ref.remove("old");
+
+  // "b" repeats (last row wins) and "old" is revived in place.
+  std::vector<std::string> ids = {"a", "b", "old", "c", "b"};
+  std::vector<float> flat;
+  std::vector<vecdb::Metadata> meta;
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    auto v = rand_vec(rng, dim);
+    flat.insert(flat.end(), v.begin(), v.end());
+    meta.push_back({{"n", std::to_string(i)}});
+    ref.upsert(ids[i], v, meta.back());
+  }
+  col.upsert_batch(ids, flat, meta);
+
+  REQUIRE_EQ(col.size(), ref.size());
+  REQUIRE_EQ(col.alive_count(), ref.alive_count());
+  REQUIRE_EQ(col.metadata_of("b")->at("n"), std::string("4"));
+  REQUIRE_EQ(col.metadata_of("old")->at("n"), std::string("2"));
+  col.build_index();
+  ref.build_index();
+  auto q = rand_vec(rng, dim);
+  auto got = col.search(q, 4, 10);
+  auto want = ref.search(q, 4, 10);
+  REQUIRE_EQ(got.size(), want.size());
+  for (std::size_t i = 0; i < got.size(); ++i) {
+    REQUIRE_EQ(col.id_at(got[i].index), ref.id_at(want[i].index));
+    REQUIRE_NEAR(got[i].distance, want[i].distance, 1e-6);
+  }
+
+  // Bad input is rejected before anything is written.
+  const std::size_t before = col.size();
+  bool threw = false;
+  try {
+    col.upsert_batch({"x", ""}, std::vector<float>(2 * dim, 1.0f));
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+  threw = false;
+  try {
+    col.upsert_batch({"x", "y"}, std::vector<float>(dim, 1.0f));
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+  REQUIRE_EQ(col.size(), before);
+  REQUIRE_TRUE(!col.contains("x"));
+}
+
+TEST_CASE(test_vector_view_inputs) {
+  std::mt19937 rng(31);
+  const std::size_t dim = 16;
+  const std::size_t n = 200;
+
+  // One flat buffer standing in for an mmap'd file or network frame.
+  std::vector<float> frame(n * dim);
+  for (auto& x : frame) x = std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < n; ++i) {
+    vecdb::Metadata meta{{"row", std::to_string(i)}};
+    store.upsert("id_" + std::to_string(i), vecdb::VectorView(frame.data() + i * dim, dim),
+                 std::move(meta));
+  }
+  REQUIRE_EQ(store.size(), n);
+  REQUIRE_EQ(store.metadata_ptr("id_7")->at("row"), std::string("7"));
+  REQUIRE_EQ(store.get_ptr("id_7")[3], frame[7 * dim + 3]);
+
+  bool threw = false;
+  try {
+    store.upsert("short", vecdb::VectorView(frame.data(), dim - 1));
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+
+  // Views and vectors give the same answers.
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  vecdb::Hnsw hnsw(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < n; ++i) hnsw.insert(i);
+  const vecdb::VectorView qv(frame.data() + 42 * dim, dim);
+  const std::vector<float> q(qv.begin(), qv.end());
+  REQUIRE_EQ(bf.search(qv, 1)[0].index, (std::size_t)42);
+  REQUIRE_TRUE(to_indices(bf.search(qv, 5)) == to_indices(bf.search(q, 5)));
+  REQUIRE_TRUE(to_indices(hnsw.search(qv, 5, 50)) == to_indices(hnsw.search(q, 5, 50)));
+}
+
+TEST_CASE(test_bruteforce_search_batch_matches_search) {
+  std::mt19937 rng(17);
+  const std::size_t dim = 24;
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < 3000; ++i) {
+    auto v = rand_vec(rng, dim);
+    for (auto& x : v) x += 3.0f;  // offset from the origin stresses the L2 expansion
+    store.upsert("id_" + std::to_string(i), v);
+  }
+  for (std::size_t i = 0; i < 3000; i += 7) store.remove("id_" + std::to_string(i));
+
+  std::vector<std::vector<float>> queries;
+  for (int i = 0; i < 70; ++i) {  // several query tiles, the last one partial
+    auto q = rand_vec(rng, dim);
+    for (auto& x : q) x += 3.0f;
+    queries.push_back(q);
+  }
+
+  for (auto metric : {vecdb::Metric::L2, vecdb::Metric::COSINE, vecdb::Metric::IP}) {
+    vecdb::Bruteforce bf(store, metric);
+    auto batch = bf.search_batch(queries, 10, /*threads=*/3);
+    REQUIRE_EQ(batch.size(), queries.size());
+    for (std::size_t qi = 0; qi < queries.size(); ++qi) {
+      auto single = bf.search(queries[qi], 10);
+      REQUIRE_EQ(batch[qi].size(), single.size());
+      for (std::size_t j = 0; j < single.size(); ++j) {
+        REQUIRE_TRUE(store.is_alive(batch[qi][j].index));
+        REQUIRE_NEAR(batch[qi][j].distance, single[j].distance, 1e-4);
+      }
+    }
+  }
+}
+
+TEST_CASE(test_evaluator_batch_truth_matches_search_fn) {
+  std::mt19937 rng(21);
+  const std::size_t dim = 24;
+  const std::size_t k = 10;
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < 2000; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  store.remove("id_3");
+
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  vecdb::Hnsw h(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < store.size(); ++i) h.insert(i);
+
+  std::vector<std::vector<float>> queries;
+  for (std::size_t i = 0; i < 40; ++i) queries.push_back(rand_vec(rng, dim));
+
+  // A small ef keeps recall below 1, so the two truths are actually compared.
+  vecdb::SearchFn approx = [&](const std::vector<float>& q, std::size_t kk) {
+    return h.search(q, kk, 10);
+  };
+  vecdb::SearchFn truth_fn = [&](const std::vector<float>& q, std::size_t kk) {
+    return bf.search(q, kk);
+  };
+
+  vecdb::Evaluator ev(store);
+  const auto per_query = ev.evaluate(queries, k, truth_fn, approx);
+  const auto batched = ev.evaluate(queries, k, bf, approx);
+  REQUIRE_TRUE(per_query.recall_at_k < 1.0);
+  REQUIRE_NEAR(batched.recall_at_k, per_query.recall_at_k, 1e-12);
+}
+
+TEST_CASE(test_inner_product_metric) {
+  std::mt19937 rng(31);
+  const std::size_t dim = 128;  // fixed-dim kernel path
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    auto v = rand_vec(rng, dim);
+    for (auto& x : v) x *= 1.0f + (float)(i % 7);  // varied norms: IP != cosine
+    store.upsert("id_" + std::to_string(i), v);
+  }
+  auto q = rand_vec(rng, dim);
+
+  vecdb::Bruteforce bf(store, vecdb::Metric::IP);
+  auto truth = bf.search(q, 10);
+  REQUIRE_EQ(truth.size(), (std::size_t)10);
+  float best = -1e30f;
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    best = std::max(best, vecdb::Distance::dot(q.data(), store.get_ptr(i), dim));
+  }
+  REQUIRE_NEAR(truth[0].distance, -best, 1e-3);
+  for (const auto& r : truth) {
+    float ref = vecdb::Distance::distance(vecdb::Metric::IP, q.data(), store.get_ptr(r.index), dim);
+    REQUIRE_NEAR(r.distance, ref, 1e-3);
+  }
+
+  vecdb::Hnsw::Params p;
+  p.seed = 31;
+  vecdb::Hnsw hnsw(store, vecdb::Metric::IP, p);
+  for (std::size_t i = 0; i < store.size(); ++i) hnsw.insert(i);
+  auto approx = hnsw.search(q, 10, /*ef_search=*/200);
+  REQUIRE_TRUE(recall_at_k(to_indices(truth), to_indices(approx)) >= 0.7);
+}
 
 TEST_CASE(test_hnsw_search_recall_small_dataset) {
   std::mt19937 rng(123);
@@ -227,6 +1152,278 @@ TEST_CASE(test_hnsw_search_recall_small_dataset) {
   REQUIRE_TRUE(avg_recall > 0.90);
 }
 
+TEST_CASE(test_hnsw_parallel_search_recall) {
+  std::mt19937 rng(321);
+  const std::size_t N = 3000;
+  const std::size_t dim = 16;
+  const std::size_t k = 10;
+  const std::size_t queries = 64;
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < N; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  vecdb::Hnsw hnsw(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < store.size(); ++i) hnsw.insert(i);
+
+  std::vector<std::vector<float>> Q;
+  for (std::size_t qi = 0; qi < queries; ++qi) Q.push_back(rand_vec(rng, dim));
+
+  // Sequential answers are the reference: a search that shared scratch with
+  // another would diverge from them (or lose recall).
+  std::vector<std::vector<std::size_t>> serial;
+  double avg_recall = 0.0;
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  for (const auto& q : Q) {
+    serial.push_back(to_indices(hnsw.search(q, k, /*ef_search=*/100)));
+    avg_recall += recall_at_k(to_indices(bf.search(q, k)), serial.back());
+  }
+  REQUIRE_TRUE(avg_recall / (double)queries > 0.90);
+
+  const std::size_t threads = std::max(4u, std::thread::hardware_concurrency());
+  std::atomic<std::size_t> mismatches{0};
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      for (std::size_t round = 0; round < 20; ++round) {
+        for (std::size_t j = 0; j < queries; ++j) {
+          const std::size_t qi = (j + t * 7) % queries;  // threads interleave queries
+          if (to_indices(hnsw.search(Q[qi], k, 100)) != serial[qi]) ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto& th : pool) th.join();
+  REQUIRE_EQ(mismatches.load(), (std::size_t)0);
+}
+
+TEST_CASE(test_hnsw_parallel_build_matches_serial_recall) {
+  std::mt19937 rng(77);
+  const std::size_t N = 3000;
+  const std::size_t dim = 16;
+  const std::size_t k = 10;
+  const std::size_t queries = 50;
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < N; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  store.remove("id_5");
+  std::vector<std::size_t> slots;
+  for (std::size_t i = 0; i < N; ++i) slots.push_back(i);
+
+  vecdb::Hnsw::Params p;
+  vecdb::Hnsw serial(store, vecdb::Metric::L2, p);
+  serial.insert_batch(slots);
+  p.build_threads = 4;
+  vecdb::Hnsw parallel(store, vecdb::Metric::L2, p);
+  parallel.insert_batch(slots);
+
+  // Levels are drawn in the same order, so the hierarchy has the same height.
+  REQUIRE_EQ(parallel.max_level(), serial.max_level());
+
+  const auto ex = parallel.export_graph();
+  REQUIRE_EQ(ex.nodes[5].level, -1);
+  for (std::size_t i = 0; i < N; ++i) {
+    for (std::size_t l = 0; l < ex.nodes[i].links.size(); ++l) {
+      const auto& nbrs = ex.nodes[i].links[l];
+      REQUIRE_TRUE(nbrs.size() <= (l == 0 ? p.M0 : p.M));
+      for (std::size_t nb : nbrs) {
+        REQUIRE_TRUE(nb != i && nb != 5);
+        REQUIRE_TRUE(ex.nodes[nb].level >= (int)l);
+      }
+    }
+  }
+
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  double r_serial = 0.0, r_parallel = 0.0;
+  for (std::size_t qi = 0; qi < queries; ++qi) {
+    auto q = rand_vec(rng, dim);
+    auto truth = to_indices(bf.search(q, k));
+    r_serial += recall_at_k(truth, to_indices(serial.search(q, k, 100)));
+    r_parallel += recall_at_k(truth, to_indices(parallel.search(q, k, 100)));
+  }
+  r_serial /= (double)queries;
+  r_parallel /= (double)queries;
+  REQUIRE_TRUE(r_parallel > 0.90);
+  REQUIRE_TRUE(r_parallel > r_serial - 0.03);
+}
+
+TEST_CASE(test_hnsw_more_tombstones_than_live) {
+  std::mt19937 rng(44);
+  const std::size_t N = 4000;
+  const std::size_t dim = 16;
+  const std::size_t k = 10;
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < N; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  vecdb::Hnsw h(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < N; ++i) h.insert(i);
+
+  // 40 live rows among 3960 unrepaired tombstones; ef is above the live count.
+  for (std::size_t i = 0; i < N; ++i) {
+    if (i % 100 != 0) store.remove("id_" + std::to_string(i));
+  }
+  REQUIRE_EQ(store.alive_count(), 40u);
+
+  vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+  for (std::size_t qi = 0; qi < 20; ++qi) {
+    auto q = rand_vec(rng, dim);
+    REQUIRE_TRUE(to_indices(h.search(q, k, 100)) == to_indices(bf.search(q, k)));
+    REQUIRE_EQ(h.search(q, 100, 100).size(), 40u);
+  }
+
+  // Inserts link to live rows only, and stay findable.
+  for (std::size_t i = 0; i < 5; ++i) {
+    auto v = rand_vec(rng, dim);
+    const std::size_t idx = store.upsert("new_" + std::to_string(i), v);
+    h.insert(idx);
+    const auto ex = h.export_graph();
+    REQUIRE_TRUE(!ex.nodes[idx].links[0].empty());
+    for (std::size_t nb : ex.nodes[idx].links[0]) REQUIRE_TRUE(store.is_alive(nb));
+    REQUIRE_EQ(h.search(v, 1, 100)[0].index, idx);
+  }
+}
+
+TEST_CASE(test_hnsw_delete_repair) {
+  std::mt19937 rng(31);
+  const std::size_t N = 3000;
+  const std::size_t dim = 16;
+  const std::size_t k = 10;
+  const std::size_t queries = 50;
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < N; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  vecdb::Hnsw h(store, vecdb::Metric::L2);
+  for (std::size_t i = 0; i < N; ++i) h.insert(i);
+
+  // Removing the entry point hands it to a live node.
+  const std::size_t old_entry = h.export_graph().entry_point;
+  store.remove("id_" + std::to_string(old_entry));
+  h.remove(old_entry);
+  auto ex = h.export_graph();
+  REQUIRE_TRUE(ex.has_entry);
+  REQUIRE_TRUE(ex.entry_point != old_entry);
+  REQUIRE_TRUE(store.is_alive(ex.entry_point));
+
+  // Eager repair: half the nodes go, each remove reconnects its neighbors.
+  for (std::size_t i = 0; i < N; i += 2) {
+    if (store.remove("id_" + std::to_string(i))) h.remove(i);
+  }
+
+  std::size_t dead_hits = 0;
+  auto recall = [&]() {
+    vecdb::Bruteforce bf(store, vecdb::Metric::L2);
+    std::mt19937 qrng(8);
+    double r = 0.0;
+    for (std::size_t qi = 0; qi < queries; ++qi) {
+      auto q = rand_vec(qrng, dim);
+      auto res = h.search(q, k, 100);
+      for (const auto& x : res) dead_hits += store.is_alive(x.index) ? 0 : 1;
+      r += recall_at_k(to_indices(bf.search(q, k)), to_indices(res));
+    }
+    return r / (double)queries;
+  };
+  REQUIRE_TRUE(recall() > 0.90);
+  REQUIRE_EQ(dead_hits, 0u);
+
+  // The batch pass leaves no edge into a tombstone and unlinks the tombstones.
+  REQUIRE_TRUE(h.repair_tombstones() > 0);
+  ex = h.export_graph();
+  for (std::size_t i = 0; i < N; ++i) {
+    if (!store.is_alive(i)) {
+      REQUIRE_EQ(ex.nodes[i].level, -1);
+      continue;
+    }
+    for (const auto& nbrs : ex.nodes[i].links) {
+      for (std::size_t nb : nbrs) REQUIRE_TRUE(store.is_alive(nb));
+    }
+  }
+  REQUIRE_TRUE(store.is_alive(ex.entry_point));
+  REQUIRE_EQ(h.repair_tombstones(), 0u);
+  REQUIRE_TRUE(recall() > 0.90);
+  REQUIRE_EQ(dead_hits, 0u);
+
+  // Revive / remove / repair churn links revived slots back into the runs
+  // they held, so the adjacency arrays stop growing.
+  const std::size_t words = h.link_words();
+  for (int cycle = 0; cycle < 4; ++cycle) {
+    for (std::size_t i = 0; i < N; i += 2) {
+      store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+      h.update(i);
+    }
+    REQUIRE_TRUE(h.export_graph().nodes[0].level >= 0);
+    for (std::size_t i = 0; i < N; i += 2) {
+      store.remove("id_" + std::to_string(i));
+      h.remove(i);
+    }
+    h.repair_tombstones();
+    REQUIRE_EQ(h.link_words(), words);
+  }
+  REQUIRE_TRUE(recall() > 0.90);
+  REQUIRE_EQ(dead_hits, 0u);
+}
+
+TEST_CASE(test_hnsw_flat_links_export_import) {
+  std::mt19937 rng(12);
+  const std::size_t N = 1500;
+  const std::size_t dim = 8;
+
+  vecdb::VectorStore store(dim);
+  for (std::size_t i = 0; i < N; ++i) {
+    store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  }
+  vecdb::Hnsw::Params p;
+  p.M = 6;
+  p.M0 = 12;
+  vecdb::Hnsw h(store, vecdb::Metric::L2, p);
+  std::vector<std::size_t> slots;
+  for (std::size_t i = 0; i < N; ++i) slots.push_back(i);
+  h.insert_batch(slots);
+
+  // Lists never outgrow their fixed-capacity runs.
+  const auto ex = h.export_graph();
+  for (const auto& node : ex.nodes) {
+    REQUIRE_TRUE(node.level >= 0);
+    for (std::size_t l = 0; l < node.links.size(); ++l) {
+      REQUIRE_TRUE(node.links[l].size() <= (l == 0 ? p.M0 : p.M));
+    }
+  }
+
+  // Import rebuilds the same graph.
+  vecdb::Hnsw h2(store, vecdb::Metric::L2, p);
+  h2.import_graph(ex);
+  const auto ex2 = h2.export_graph();
+  REQUIRE_EQ(ex2.entry_point, ex.entry_point);
+  REQUIRE_EQ(ex2.max_level, ex.max_level);
+  for (std::size_t i = 0; i < N; ++i) {
+    REQUIRE_EQ(ex2.nodes[i].level, ex.nodes[i].level);
+    REQUIRE_TRUE(ex2.nodes[i].links == ex.nodes[i].links);
+  }
+  auto q = rand_vec(rng, dim);
+  REQUIRE_TRUE(to_indices(h2.search(q, 10, 50)) == to_indices(h.search(q, 10, 50)));
+
+  // Lists that cannot fit (saved with a larger M0) or point outside the
+  // store are rejected.
+  auto too_wide = ex;
+  while (too_wide.nodes[0].links[0].size() <= p.M0) too_wide.nodes[0].links[0].push_back(1);
+  auto out_of_range = ex;
+  out_of_range.nodes[0].links[0].back() = N;
+  for (const auto* bad : {&too_wide, &out_of_range}) {
+    bool threw = false;
+    try {
+      h2.import_graph(*bad);
+    } catch (const std::runtime_error&) {
+      threw = true;
+    }
+    REQUIRE_TRUE(threw);
+  }
+}
+
 
 TEST_CASE(test_collection_persistence_roundtrip) {
   namespace fs = std::filesystem;
@@ -271,6 +1468,80 @@ TEST_CASE(test_collection_persistence_roundtrip) {
   REQUIRE_NEAR(res[0].distance, 0.02, 1e-6);
 }
 
+TEST_CASE(test_collection_normalize_requires_cosine) {
+  auto dir = make_temp_dir("normalize_requires_cosine");
+
+  vecdb::Collection::Options opt;
+  opt.dim = 4;
+  opt.metric = vecdb::Metric::L2;
+  opt.normalize = true;
+
+  bool threw = false;
+  try {
+    vecdb::Collection::create(dir.string(), opt);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+
+  opt.metric = vecdb::Metric::COSINE;
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  threw = false;
+  try {
+    col.set_metric(vecdb::Metric::IP);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  REQUIRE_TRUE(threw);
+  REQUIRE_TRUE(col.metric() == vecdb::Metric::COSINE);
+}
+
+TEST_CASE(test_collection_normalize_on_ingest) {
+  std::mt19937 rng(21);
+  auto dir = make_temp_dir("normalize_on_ingest");
+
+  vecdb::Collection::Options opt;
+  opt.dim = 16;
+  opt.metric = vecdb::Metric::COSINE;
+  opt.normalize = true;
+
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  std::vector<std::vector<float>> raw;
+  for (std::size_t i = 0; i < 300; ++i) {
+    auto v = rand_vec(rng, opt.dim);
+    for (auto& x : v) x *= 3.f;  // deliberately not unit length
+    raw.push_back(v);
+    vecdb::Metadata meta;
+    meta["g"] = (i % 2) ? "odd" : "even";
+    col.upsert("id_" + std::to_string(i), v, meta);
+  }
+  col.build_index();
+  col.save();
+
+  auto col2 = vecdb::Collection::open(dir.string());
+  REQUIRE_TRUE(col2.normalized());
+
+  auto q = rand_vec(rng, opt.dim);
+  auto res = col2.search(q, 5, 100);
+  REQUIRE_EQ(res.size(), (std::size_t)5);
+  for (const auto& r : res) {
+    float ref = vecdb::Distance::cosine_distance(q.data(), raw[r.index].data(), opt.dim);
+    REQUIRE_NEAR(r.distance, ref, 1e-5);
+  }
+
+  // Filtered scan goes through the same 1 - dot path.
+  vecdb::Collection::MetadataFilter filter;
+  filter.key = "g";
+  filter.value = "odd";
+  auto exact = col2.search(q, 5, 100, filter);
+  REQUIRE_EQ(exact.size(), (std::size_t)5);
+  for (const auto& r : exact) {
+    REQUIRE_EQ(r.index % 2, (std::size_t)1);
+    float ref = vecdb::Distance::cosine_distance(q.data(), raw[r.index].data(), opt.dim);
+    REQUIRE_NEAR(r.distance, ref, 1e-5);
+  }
+}
+
 TEST_CASE(test_collection_concurrent_reads) {
   std::mt19937 rng(123);
   vecdb::Collection::Options opt;
@@ -372,6 +1643,188 @@ TEST_CASE(test_collection_concurrent_read_write) {
   REQUIRE_TRUE(ok.load());
 }
 
+TEST_CASE(test_collection_index_stays_live_across_writes) {
+  std::mt19937 rng(99);
+  const std::size_t dim = 16;
+  const std::size_t k = 10;
+
+  vecdb::Collection::Options opt;
+  opt.dim = dim;
+  opt.metric = vecdb::Metric::L2;
+  auto dir = make_temp_dir("index_live_writes");
+  auto col = vecdb::Collection::create(dir.string(), opt);
+
+  std::vector<std::vector<float>> rows;
+  for (std::size_t i = 0; i < 2000; ++i) {
+    rows.push_back(rand_vec(rng, dim));
+    col.upsert("id_" + std::to_string(i), rows.back());
+  }
+  col.build_index();
+
+  // New slots are linked in: one at a time and in bulk.
+  for (std::size_t i = 2000; i < 2300; ++i) {
+    rows.push_back(rand_vec(rng, dim));
+    col.upsert("id_" + std::to_string(i), rows.back());
+  }
+  std::vector<std::string> batch_ids;
+  std::vector<float> batch;
+  for (std::size_t i = 2300; i < 2500; ++i) {
+    rows.push_back(rand_vec(rng, dim));
+    batch_ids.push_back("id_" + std::to_string(i));
+    batch.insert(batch.end(), rows.back().begin(), rows.back().end());
+  }
+  col.upsert_batch(batch_ids, batch);
+  REQUIRE_TRUE(col.has_index());
+  for (std::size_t i = 2000; i < 2500; i += 37) {
+    auto res = col.search(rows[i], 1, 100);
+    REQUIRE_EQ(col.id_at(res[0].index), "id_" + std::to_string(i));
+  }
+
+  // Changed rows are re-linked and found at their new position.
+  for (std::size_t i = 0; i < 200; ++i) {
+    rows[i] = rand_vec(rng, dim);
+    col.upsert("id_" + std::to_string(i), rows[i]);
+  }
+  for (std::size_t i = 0; i < 200; i += 13) {
+    auto res = col.search(rows[i], 1, 100);
+    REQUIRE_EQ(col.id_at(res[0].index), "id_" + std::to_string(i));
+  }
+
+  // Removes are tombstones: never returned, and recall over the live rows holds.
+  std::vector<bool> removed(rows.size(), false);
+  for (std::size_t i = 0; i < rows.size(); i += 3) {
+    REQUIRE_TRUE(col.remove("id_" + std::to_string(i)));
+    removed[i] = true;
+  }
+  REQUIRE_TRUE(col.has_index());
+
+  auto check = [&](const vecdb::Collection& c, double& recall) {
+    recall = 0.0;
+    std::mt19937 qrng(5);
+    const std::size_t queries = 40;
+    for (std::size_t qi = 0; qi < queries; ++qi) {
+      auto q = rand_vec(qrng, dim);
+      std::vector<vecdb::SearchResult> truth;
+      for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (!removed[i]) truth.push_back({i, vecdb::Distance::l2_sq(q.data(), rows[i].data(), dim)});
+      }
+      std::sort(truth.begin(), truth.end(),
+                [](const vecdb::SearchResult& a, const vecdb::SearchResult& b) { return a.distance < b.distance; });
+      truth.resize(k);
+      auto res = c.search(q, k, 100);
+      for (const auto& r : res) {
+        if (removed[r.index]) return false;
+      }
+      recall += recall_at_k(to_indices(truth), to_indices(res));
+    }
+    recall /= (double)queries;
+    return true;
+  };
+  double recall = 0.0;
+  REQUIRE_TRUE(check(col, recall));
+  REQUIRE_TRUE(recall > 0.90);
+  REQUIRE_TRUE(col.repair_index() > 0);
+  REQUIRE_TRUE(check(col, recall));
+  REQUIRE_TRUE(recall > 0.90);
+
+  col.save();
+  auto col2 = vecdb::Collection::open(dir.string());
+  REQUIRE_TRUE(col2.has_index());
+  REQUIRE_TRUE(check(col2, recall));
+  REQUIRE_TRUE(recall > 0.90);
+}
+
+TEST_CASE(test_collection_bulk_load_drops_index) {
+  std::mt19937 rng(73);
+  const std::size_t dim = 16;
+
+  vecdb::Collection::Options opt;
+  opt.dim = dim;
+  auto dir = make_temp_dir("bulk_load_drop_index");
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  for (std::size_t i = 0; i < 500; ++i) col.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  col.build_index();
+  col.save();
+  REQUIRE_TRUE(std::filesystem::exists(dir / "hnsw.bin"));
+
+  // What load --build does with an indexed collection: drop the index, ingest
+  // with nothing to link into, then build once.
+  auto reopened = vecdb::Collection::open(dir.string());
+  REQUIRE_TRUE(reopened.has_index());
+  reopened.drop_index();
+  std::vector<std::string> ids;
+  std::vector<float> rows;
+  for (std::size_t i = 500; i < 1500; ++i) {
+    ids.push_back("id_" + std::to_string(i));
+    auto v = rand_vec(rng, dim);
+    rows.insert(rows.end(), v.begin(), v.end());
+  }
+  reopened.upsert_batch(ids, rows);
+  REQUIRE_FALSE(reopened.has_index());
+  REQUIRE_EQ(reopened.alive_count(), 1500u);
+
+  reopened.build_index();
+  reopened.save();
+  auto rebuilt = vecdb::Collection::open(dir.string());
+  REQUIRE_TRUE(rebuilt.has_index());
+  for (std::size_t i = 0; i < 1000; i += 97) {
+    std::vector<float> v(rows.begin() + i * dim, rows.begin() + (i + 1) * dim);
+    REQUIRE_EQ(rebuilt.id_at(rebuilt.search(v, 1, 100)[0].index), ids[i]);
+  }
+
+  // Saving without an index removes the stale graph file.
+  rebuilt.drop_index();
+  rebuilt.save();
+  REQUIRE_FALSE(std::filesystem::exists(dir / "hnsw.bin"));
+  REQUIRE_FALSE(vecdb::Collection::open(dir.string()).has_index());
+}
+
+TEST_CASE(test_dead_rows_survive_save_and_open) {
+  std::mt19937 rng(61);
+  const std::size_t dim = 16;
+
+  // Removed slots keep their stored row bytes through vectors.bin.
+  for (auto fmt : {vecdb::RowFormat::F32, vecdb::RowFormat::F16}) {
+    vecdb::VectorStore store(dim, fmt);
+    for (std::size_t i = 0; i < 20; ++i) store.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+    store.remove("id_3");
+    store.remove("id_11");
+    auto dir = make_temp_dir("dead_rows_" + std::string(vecdb::row_format_to_string(fmt)));
+    vecdb::Serializer::save_store(dir.string(), store);
+    vecdb::VectorStore loaded(dim, fmt);
+    vecdb::Serializer::load_store(dir.string(), loaded);
+    REQUIRE_FALSE(loaded.is_alive(3));
+    std::vector<float> a(dim), b(dim);
+    for (std::size_t i : {std::size_t{3}, std::size_t{11}}) {
+      const float* before = store.row_f32(i, a.data());
+      const float* after = loaded.row_f32(i, b.data());
+      for (std::size_t d = 0; d < dim; ++d) REQUIRE_EQ(after[d], before[d]);
+      REQUIRE_EQ(loaded.inv_norm(i), store.inv_norm(i));
+    }
+  }
+
+  // So a reopened index with tombstones in its graph searches the same.
+  vecdb::Collection::Options opt;
+  opt.dim = dim;
+  opt.metric = vecdb::Metric::COSINE;
+  auto dir = make_temp_dir("dead_rows_collection");
+  auto col = vecdb::Collection::create(dir.string(), opt);
+  for (std::size_t i = 0; i < 1500; ++i) col.upsert("id_" + std::to_string(i), rand_vec(rng, dim));
+  col.build_index();
+  for (std::size_t i = 0; i < 1500; i += 2) col.remove("id_" + std::to_string(i));
+  std::vector<std::vector<float>> queries;
+  for (std::size_t i = 0; i < 20; ++i) queries.push_back(rand_vec(rng, dim));
+  std::vector<std::vector<std::size_t>> before;
+  for (const auto& q : queries) before.push_back(to_indices(col.search(q, 10, 40)));
+  col.save();
+
+  auto col2 = vecdb::Collection::open(dir.string());
+  REQUIRE_TRUE(col2.has_index());
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    REQUIRE_TRUE(to_indices(col2.search(queries[i], 10, 40)) == before[i]);
+  }
+}
+
 // ---------------- Runner ----------------
 int main() {
   std::cout << "VecDB tests starting...\n";